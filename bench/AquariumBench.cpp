@@ -0,0 +1,298 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include "sim/AquariumSim.h"
+
+// Microbenchmarks for the simulation hot paths.
+//
+// usage: aquarium_bench [--max N] [--min-time SECONDS] [--workers N] [--seed N] [--json FILE] [--csv FILE]
+//
+// Every benchmark runs once per population size (10, 100, ... up to --max) and
+// reports the average nanoseconds per operation. Results print as a table and
+// can also be written as JSON/CSV so two builds can be diffed. --workers sets
+// the sim job system size (0, the default, is one per core). --seed picks the
+// populations (1234 by default), every world of a size is the same for a seed.
+
+namespace {
+
+struct BenchResult {
+    std::string name;
+    int creatures;
+    long long iterations;
+    double nsPerOp;
+};
+
+// keeps the optimizer from throwing away work whose result we never look at
+volatile long long g_sink = 0;
+
+// times body(iterations) with growing batches until it runs for at least minTime
+BenchResult RunBench(const std::string& name, int creatures, double minTime, const std::function<void(long long)>& body) {
+    long long iterations = 1;
+    double elapsed = 0.0;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= minTime || iterations >= (1LL << 30)) break;
+        // aim a bit past minTime from what we've seen so far
+        long long next = elapsed > 0 ? (long long)(iterations * (minTime * 1.4 / elapsed)) : iterations * 10;
+        iterations = std::max(iterations * 2, std::min(next, iterations * 100));
+    }
+    return BenchResult{name, creatures, iterations, elapsed * 1e9 / iterations};
+}
+
+// level with a single NPCreature population of the requested size, so
+// Repopulate has n creatures to hand back every time it is reset
+class BenchLevel : public AquariumLevel {
+    public:
+        BenchLevel(int population) : AquariumLevel(0, 1 << 30) {
+            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, population));
+        }
+        void setupWavePattern() override { m_maxWaves = 0; m_timeBetweenWaves = 2.0f; }
+        std::vector<AquariumCreatureType> getWaveCreatures(int /*waveNumber*/) override { return {}; }
+        std::string getLevelDescription() const override { return "bench"; }
+};
+
+struct BenchWorld {
+    std::shared_ptr<Aquarium> aquarium;
+    std::shared_ptr<PlayerCreature> player;
+};
+
+uint64_t g_seed = 1234;
+
+// aquarium filled with a mix of the stock creatures, player parked off screen so
+// collision scans never stop early
+BenchWorld MakeWorld(int creatures, int width = 1024, int height = 768) {
+    SetSimSeed(g_seed); // same population whatever ran before
+    BenchWorld world;
+    world.aquarium = std::make_shared<Aquarium>(width, height, nullptr);
+    std::shared_ptr<AquariumLevel> level = std::make_shared<BenchLevel>(creatures);
+    level->initialize();
+    world.aquarium->addAquariumLevel(level);
+    world.player = std::make_shared<PlayerCreature>(-10000, -10000, 5, nullptr);
+
+    const AquariumCreatureType mix[] = {
+        AquariumCreatureType::NPCreature, AquariumCreatureType::NPCreature, AquariumCreatureType::NPCreature,
+        AquariumCreatureType::BiggerFish, AquariumCreatureType::AnglerFish, AquariumCreatureType::GyaradosFish,
+    };
+    for (int i = 0; i < creatures; ++i) {
+        world.aquarium->SpawnCreature(mix[i % 6]);
+    }
+    return world;
+}
+
+void WriteJson(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"creatures\": " << r.creatures
+            << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.nsPerOp << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+void WriteCsv(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << "name,creatures,iterations,ns_per_op\n";
+    for (const BenchResult& r : results) {
+        out << r.name << "," << r.creatures << "," << r.iterations << "," << r.nsPerOp << "\n";
+    }
+}
+
+}
+
+int main(int argc, char** argv){
+    int maxCreatures = 100000;
+    double minTime = 0.2;
+    std::string jsonPath;
+    std::string csvPath;
+    int workers = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--max" && hasValue) { maxCreatures = std::atoi(argv[++i]); }
+        else if (arg == "--min-time" && hasValue) { minTime = std::atof(argv[++i]); }
+        else if (arg == "--workers" && hasValue) { workers = std::atoi(argv[++i]); }
+        else if (arg == "--seed" && hasValue) { g_seed = std::strtoull(argv[++i], nullptr, 10); }
+        else if (arg == "--json" && hasValue) { jsonPath = argv[++i]; }
+        else if (arg == "--csv" && hasValue) { csvPath = argv[++i]; }
+        else {
+            std::cerr << "usage: " << argv[0] << " [--max N] [--min-time SECONDS] [--workers N] [--seed N] [--json FILE] [--csv FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    SetSimLogLevel(SimLogLevel::Silent);
+    SetSimWorkerCount(workers);
+    std::printf("workers: %d\n", SimJobSystem().GetWorkerCount());
+
+    std::vector<BenchResult> results;
+    auto report = [&](BenchResult r) {
+        std::printf("%-28s %8d %12lld %14.1f ns/op\n", r.name.c_str(), r.creatures, r.iterations, r.nsPerOp);
+        results.push_back(r);
+    };
+
+    for (int n = 10; n <= maxCreatures; n *= 10) {
+        // one player against every creature, what DetectAquariumCollisions does per creature
+        {
+            BenchWorld world = MakeWorld(n);
+            std::shared_ptr<Creature> player = world.player;
+            const std::vector<std::shared_ptr<Creature>>& creatures = world.aquarium->getCreatures();
+            BenchResult r = RunBench("checkCollision", n, minTime, [&](long long iterations) {
+                long long hits = 0;
+                for (long long i = 0; i < iterations; ++i) {
+                    hits += checkCollision(player, creatures[i % creatures.size()]);
+                }
+                g_sink += hits;
+            });
+            report(r);
+        }
+        {
+            BenchWorld world = MakeWorld(n);
+            report(RunBench("DetectAquariumCollisions", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    g_sink += DetectAquariumCollisions(world.aquarium, world.player) != nullptr;
+                }
+            }));
+        }
+        // every hit into the event queue, what the simulation does each step
+        {
+            BenchWorld world = MakeWorld(n);
+            SimEventQueue events;
+            report(RunBench("DetectAquariumCollisions/queue", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    events.Clear();
+                    g_sink += DetectAquariumCollisions(world.aquarium, world.player, events);
+                }
+            }));
+        }
+        {
+            BenchWorld world = MakeWorld(n);
+            report(RunBench("Aquarium::update", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    world.aquarium->update(world.player);
+                }
+            }));
+        }
+        // same tick on the calling thread only, to compare against the pool
+        {
+            BenchWorld world = MakeWorld(n);
+            SetSimWorkerCount(1);
+            report(RunBench("Aquarium::update/serial", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    world.aquarium->update(world.player);
+                }
+            }));
+            SetSimWorkerCount(workers);
+        }
+        // the passive movement pass alone, once per kernel the cpu can run
+        for (int k = 0; k <= (int)BestMotionKernel(); ++k) {
+            MotionKernel kernel = MotionKernel(k);
+            BenchWorld world = MakeWorld(n);
+            CreatureStore store = world.aquarium->getStore();
+            report(RunBench(std::string("IntegratePassive/") + MotionKernelToString(kernel), n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    IntegratePassive(store, kernel);
+                }
+                g_sink += store.flipped[0];
+            }));
+        }
+        // one circle against every creature's store arrays, the narrowphase
+        // primitive on its own, once per kernel
+        for (int k = 0; k <= (int)BestMotionKernel(); ++k) {
+            MotionKernel kernel = MotionKernel(k);
+            BenchWorld world = MakeWorld(n);
+            const CreatureStore& store = world.aquarium->getStore();
+            std::vector<int> hits;
+            report(RunBench(std::string("OverlapIndices/") + MotionKernelToString(kernel), n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    hits.clear();
+                    g_sink += OverlapIndices(512.0f, 384.0f, 60.0f, store.x.data(), store.y.data(), store.radius.data(),
+                                             store.size(), hits, 0, kernel);
+                }
+            }));
+        }
+        // same tick with the sort-and-sweep NPC pass and separation on. The tank
+        // grows with n to keep about 100 fish per screen, otherwise every fish
+        // overlaps every other one and the pair count is all we'd measure
+        {
+            float scale = std::max(1.0f, std::sqrt(n / 100.0f));
+            BenchWorld world = MakeWorld(n, 1024 * scale, 768 * scale);
+            world.aquarium->setNPCCollisionsEnabled(true);
+            world.aquarium->setNPCSeparationEnabled(true);
+            report(RunBench("Aquarium::update+npc", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    world.aquarium->update(world.player);
+                }
+                g_sink += world.aquarium->getNPCOverlaps().size();
+            }));
+        }
+        // n base fish schooling in a 1080p tank, the showcase scene. Dense on
+        // purpose, the neighbour cap is what keeps this linear
+        {
+            BenchWorld world = MakeWorld(0, 1920, 1080);
+            for (int i = 0; i < n; ++i) {
+                world.aquarium->SpawnCreature(AquariumCreatureType::NPCreature);
+            }
+            world.aquarium->setSchoolingEnabled(true);
+            report(RunBench("Aquarium::update+school", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    world.aquarium->update(world.player);
+                }
+            }));
+        }
+        // take a creature out from the middle and put it back so n stays fixed
+        {
+            BenchWorld world = MakeWorld(n);
+            report(RunBench("Aquarium::removeCreature", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    std::shared_ptr<Creature> victim = world.aquarium->getCreatureAt(world.aquarium->getCreatureCount() / 2);
+                    world.aquarium->removeCreature(victim);
+                    world.aquarium->addCreature(victim);
+                }
+            }));
+        }
+        // the aquarium grows by one creature per iteration on top of the initial n
+        {
+            BenchWorld world = MakeWorld(n);
+            report(RunBench("Aquarium::SpawnCreature", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    world.aquarium->SpawnCreature(AquariumCreatureType::NPCreature);
+                }
+                g_sink += world.aquarium->getCreatureCount();
+            }));
+        }
+        // a creature dies and a new one takes its place, the steady state of a
+        // wave. Spawn allocates from the aquarium's creature pool
+        {
+            BenchWorld world = MakeWorld(n);
+            report(RunBench("Aquarium::spawn+remove", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    world.aquarium->SpawnCreature(AquariumCreatureType::NPCreature);
+                    world.aquarium->removeCreature(world.aquarium->getCreatureAt(world.aquarium->getCreatureCount() - 1));
+                }
+            }));
+        }
+        {
+            BenchLevel level(n);
+            level.initialize();
+            report(RunBench("AquariumLevel::Repopulate", n, minTime, [&](long long iterations) {
+                for (long long i = 0; i < iterations; ++i) {
+                    level.populationReset();
+                    g_sink += level.Repopulate().size();
+                }
+            }));
+        }
+    }
+
+    if (!jsonPath.empty()) WriteJson(jsonPath, results);
+    if (!csvPath.empty()) WriteCsv(csvPath, results);
+    return 0;
+}
@@ -0,0 +1,52 @@
+# Headless build of the aquarium simulation (src/sim), no openFrameworks needed.
+#
+#   make -f headless.mk              builds lib/libaquariumsim.a and bin/aquarium_headless
+#   make -f headless.mk bench        builds bin/aquarium_bench
+#   make -f headless.mk run-bench    runs it and writes bench_results.json/.csv
+#   make -f headless.mk clean
+#
+# The regular Makefile still builds the full app, src/sim is compiled into it too.
+
+CXX ?= g++
+CXXFLAGS ?= -O2 -g
+CXXFLAGS += -std=c++17 -Wall -Isrc -pthread
+
+SIM_SOURCES := $(wildcard src/sim/*.cpp)
+SIM_OBJECTS := $(patsubst src/sim/%.cpp,obj/headless/sim/%.o,$(SIM_SOURCES))
+SIM_LIB := lib/libaquariumsim.a
+
+HEADLESS_BIN := bin/aquarium_headless
+BENCH_BIN := bin/aquarium_bench
+BENCH_ARGS ?=
+
+.PHONY: all simlib headless bench run-bench clean
+
+all: simlib headless
+
+simlib: $(SIM_LIB)
+
+headless: $(HEADLESS_BIN)
+
+$(SIM_LIB): $(SIM_OBJECTS)
+	@mkdir -p $(dir $@)
+	$(AR) rcs $@ $^
+
+obj/headless/sim/%.o: src/sim/%.cpp $(wildcard src/sim/*.h)
+	@mkdir -p $(dir $@)
+	$(CXX) $(CXXFLAGS) -c $< -o $@
+
+$(HEADLESS_BIN): headless/HeadlessMain.cpp $(SIM_LIB)
+	@mkdir -p $(dir $@)
+	$(CXX) $(CXXFLAGS) $< -o $@ -L$(dir $(SIM_LIB)) -laquariumsim
+
+bench: $(BENCH_BIN)
+
+$(BENCH_BIN): bench/AquariumBench.cpp $(SIM_LIB)
+	@mkdir -p $(dir $@)
+	$(CXX) $(CXXFLAGS) $< -o $@ -L$(dir $(SIM_LIB)) -laquariumsim
+
+run-bench: $(BENCH_BIN)
+	./$(BENCH_BIN) --json bench_results.json --csv bench_results.csv $(BENCH_ARGS)
+
+clean:
+	rm -rf obj/headless $(SIM_LIB) $(HEADLESS_BIN) $(BENCH_BIN)
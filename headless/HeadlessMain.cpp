@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "sim/AquariumSim.h"
+
+// Runs the aquarium simulation without a window, as fast as the machine allows.
+// usage: aquarium_headless [ticks] [width] [height] [workers] [tickRate] [seed]
+// workers: threads for Aquarium::update, 0 (default) uses every core
+// tickRate: simulation ticks per game second, 60 by default
+// seed: for every random choice in the run (1 by default), same seed same run
+// Levels come from bin/data/settings.xml like in the app (run from the repo root).
+//
+// --record FILE writes the run's seed and key presses to an input log,
+// --replay FILE plays one back (from here or the app) instead of wandering:
+// ticks, size, tick rate and seed then come from the log.
+// --load FILE starts from a save state instead of level 1, --save FILE
+// writes one when the run ends. An input log always starts at level 1, so
+// --load can't be combined with --record or --replay.
+// --school turns on boids schooling for the base fish.
+
+int main(int argc, char** argv){
+    std::string recordPath;
+    std::string replayPath;
+    std::string loadPath;
+    std::string savePath;
+    bool schooling = false;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) { recordPath = argv[++i]; }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) { replayPath = argv[++i]; }
+        else if (std::strcmp(argv[i], "--load") == 0 && i + 1 < argc) { loadPath = argv[++i]; }
+        else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) { savePath = argv[++i]; }
+        else if (std::strcmp(argv[i], "--school") == 0) { schooling = true; }
+        else { args.push_back(argv[i]); }
+    }
+    if (!loadPath.empty() && (!recordPath.empty() || !replayPath.empty())) {
+        std::cerr << "--load can't be used with --record or --replay" << std::endl;
+        return 1;
+    }
+    int argCount = (int)args.size();
+    int ticks = argCount > 1 ? std::atoi(args[1]) : 10000;
+    int width = argCount > 2 ? std::atoi(args[2]) : 1024;
+    int height = argCount > 3 ? std::atoi(args[3]) : 768;
+    int workers = argCount > 4 ? std::atoi(args[4]) : 0;
+    int tickRate = argCount > 5 ? std::max(1, std::atoi(args[5])) : 60;
+    uint64_t seed = argCount > 6 ? std::strtoull(args[6], nullptr, 10) : 1;
+
+    InputLog replay;
+    if (!replayPath.empty()) {
+        if (!replay.Load(replayPath)) {
+            std::cerr << "can't read input log " << replayPath << std::endl;
+            return 1;
+        }
+        ticks = (int)replay.tickCount;
+        width = replay.width;
+        height = replay.height;
+        tickRate = std::max(1, (int)std::lround(replay.tickRate));
+        seed = replay.seed;
+    }
+
+    SetSimLogLevel(SimLogLevel::Warning); // per-wave notices would dominate the run
+    SetSimWorkerCount(workers);
+    SetSimSeed(seed);
+
+    std::shared_ptr<const LevelTable> levels = LoadLevelTable("bin/data/settings.xml", "bin/data/settings.bin");
+    std::shared_ptr<Aquarium> aquarium = std::make_shared<Aquarium>(width, height, nullptr);
+    aquarium->setSchoolingEnabled(schooling);
+    std::shared_ptr<PlayerCreature> player = std::make_shared<PlayerCreature>(width/2 - 50, height/2 - 50, levels->playerSpeed, nullptr);
+    player->setDirection(0, 0);
+    player->setBounds(width - 20, height - 20);
+    InitializeAquariumLevels(aquarium, player, levels);
+
+    AquariumSimulation simulation(player, aquarium);
+    simulation.SetTickRate(tickRate);
+    if (!loadPath.empty() && !simulation.LoadSnapshot(loadPath)) {
+        return 1;
+    }
+    InputLog record;
+    record.seed = seed;
+    record.tickRate = tickRate;
+    record.width = width;
+    record.height = height;
+    if (!recordPath.empty()) simulation.SetRecorder(&record);
+    if (!replayPath.empty()) simulation.SetReplay(&replay);
+
+    Pcg32 input = MakeSimRandom(SimRandomStream::Input);
+    bool held[(int)PlayerKey::Count] = {};
+    auto start = std::chrono::steady_clock::now();
+    int tick = 0;
+    for (; tick < ticks; ++tick) {
+        // wander around like a player holding the arrow keys for a second at a time
+        if (replayPath.empty() && tick % tickRate == 0) {
+            int dx = input.range(-1, 1);
+            int dy = input.range(-1, 1);
+            for (int key = 0; key < (int)PlayerKey::Count; ++key) {
+                if (held[key]) simulation.PressKey(PlayerKey(key), false);
+                held[key] = false;
+            }
+            PlayerKey keys[2] = {dx < 0 ? PlayerKey::Left : PlayerKey::Right, dy < 0 ? PlayerKey::Up : PlayerKey::Down};
+            bool press[2] = {dx != 0, dy != 0};
+            for (int axis = 0; axis < 2; ++axis) {
+                if (!press[axis]) continue;
+                simulation.PressKey(keys[axis], true);
+                held[(int)keys[axis]] = true;
+            }
+        }
+        simulation.Tick();
+        if (simulation.GetLastEvent() != nullptr && simulation.GetLastEvent()->isGameOver()) {
+            ++tick;
+            break;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!savePath.empty()) {
+        simulation.SaveSnapshot(savePath);
+    }
+    if (!recordPath.empty()) {
+        record.tickCount = simulation.GetTickCount();
+        if (!record.Save(recordPath)) {
+            std::cerr << "can't write input log " << recordPath << std::endl;
+        }
+    }
+
+    std::cout << "ticks: " << tick
+              << " seconds: " << elapsed.count()
+              << " ticks/s: " << (elapsed.count() > 0 ? tick / elapsed.count() : 0.0)
+              << " game seconds: " << tick / (double)tickRate
+              << " creatures: " << aquarium->getCreatureCount()
+              << " level: " << aquarium->getCurrentLevelIndex() + 1
+              << " score: " << player->getScore()
+              << " lives: " << player->getLives()
+              << " workers: " << SimJobSystem().GetWorkerCount()
+              << " seed: " << GetSimSeed() << std::endl;
+    return 0;
+}
@@ -1,490 +1,226 @@
 #include "Aquarium.h"
-#include <cstdlib>
-
-
-string AquariumCreatureTypeToString(AquariumCreatureType t){
-    switch(t){
-        case AquariumCreatureType::BiggerFish:
-            return "BiggerFish";
-        case AquariumCreatureType::NPCreature:
-            return "BaseFish";
-        default:
-            return "UknownFish";
-    }
-}
-
-// PlayerCreature Implementation
-PlayerCreature::PlayerCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-: Creature(x, y, speed, 10.0f, 1, sprite){
-    m_powerupSprite=nullptr;
-    m_normalSprite=sprite;
-    m_type = AquariumCreatureType::Player;
-}
-
-
-void PlayerCreature::setDirection(float dx, float dy) {
-    m_dx = dx;
-    m_dy = dy;
-    normalize();
-}
-
-void PlayerCreature::move() {
-    m_x += m_dx * m_speed;
-    m_y += m_dy * m_speed;
-    this->bounce();
-}
-
-void PlayerCreature::reduceDamageDebounce() {
-    if (m_damage_debounce > 0) {
-        --m_damage_debounce;
-    }
-}
-
-void PlayerCreature::update() {
-    this->reduceDamageDebounce();
-    this->move();
-    this->updateSizeBoost();
-    this->updateSpeedFruit();
-}
-
-
-void PlayerCreature::draw() const {
-    
-    ofLogVerbose() << "PlayerCreature at (" << m_x << ", " << m_y << ") with speed " << m_speed << std::endl;
-    if (this->m_damage_debounce > 0) {
-        ofSetColor(ofColor::red); // Flash red if in damage debounce
-    }
-    if (m_sprite) {
-      m_sprite->draw(m_x, m_y);
-    }
-    ofSetColor(ofColor::white); // Reset color
-
-}
-
-void PlayerCreature::changeSpeed(int speed) {
-    m_speed = speed;
-}
-
-void PlayerCreature::loseLife(int debounce) {
-    if (m_damage_debounce <= 0) {
-        if (m_lives > 0) this->m_lives -= 1;
-        m_damage_debounce = debounce; // Set debounce frames
-        ofLogNotice() << "Player lost a life! Lives remaining: " << m_lives << std::endl;
-    }
-    // If in debounce period, do nothing
-    if (m_damage_debounce > 0) {
-        ofLogVerbose() << "Player is in damage debounce period. Frames left: " << m_damage_debounce << std::endl;
-    }
-}
-void PlayerCreature::activateSizeBoost(){
-if(!m_sizeActive){
-    m_sizeActive=true;
-    m_sizeTimer=m_sizeDuration;
-    m_power +=1;
-    if(!m_powerupSprite) {
-        m_powerupSprite = std::make_shared<GameSprite>("pez_Espada.png", 100, 100);
-        }
-        this->setSprite(m_powerupSprite);
-    m_sizeScale=1.5f;
-     setCollisionRadius(m_defaultCollisionRad * m_sizeScale);
-    ofLogNotice() << "Grow-Grow Devil Fruit Activated! Power: " << m_power;
-    }
-}
-void PlayerCreature::updateSizeBoost(){
-    if(m_sizeActive){
-        if(--m_sizeTimer<=0){
-            m_sizeActive=false;
-            m_sizeScale=1.0f;
-            m_power-=1;
-          this->setSprite(m_normalSprite);
-            ofLogNotice() << "Size Boost Ended. Power: " << m_power;
-        }
-    }
-}
-void PlayerCreature::activateSpeedFruit(){
-    if(!m_speedFruitActive){
-         m_speedFruitActive = true;
-        m_speedFruitTime = m_speedFruitDuration;
-        m_speedNormal = m_speed;
-        m_speed *= 1.5f;
-        ofLogNotice() << " Light-Speed Fruit Activated! New Speed: " << m_speed;
-    }
-}
-void PlayerCreature::updateSpeedFruit() {
-    if (m_speedFruitActive) {
-        if (--m_speedFruitTime <= 0) {
-            m_speedFruitActive = false;
-            m_speed = m_speedNormal; // Restaura velocidad
-            ofLogNotice() << "Speed Boost Ended. Speed: " << m_speed;
-        }
-    }
-}
-
-// NPCreature Implementation
-NPCreature::NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-: Creature(x, y, speed, 30, 1, sprite) {
-    m_dx = (rand() % 3 - 1); // -1, 0, or 1
-    m_dy = (rand() % 3 - 1); // -1, 0, or 1
-    normalize();
-
-    m_type = AquariumCreatureType::NPCreature;
-    m_value=2;
-    m_powerRequired=1;
-}
-
-void NPCreature::move() {
-    // Simple AI movement logic (random direction)
-    m_x += m_dx * m_speed;
-    m_y += m_dy * m_speed;
-    if(m_dx < 0 ){
-        this->m_sprite->setFlipped(true);
-    }else {
-        this->m_sprite->setFlipped(false);
-    }
-    bounce();
-}
-
-void NPCreature::draw() const {
-    ofLogVerbose() << "NPCreature at (" << m_x << ", " << m_y << ") with speed " << m_speed << std::endl;
-    ofSetColor(ofColor::white);
-    if (m_sprite) {
-        m_sprite->draw(m_x, m_y);
-    }
-}
-
-
-BiggerFish::BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-: NPCreature(x, y, speed, sprite) {
-    m_dx = (rand() % 3 - 1);
-    m_dy = (rand() % 3 - 1);
-    normalize();
-
-    setCollisionRadius(60); // Bigger fish have a larger collision radius
-    m_value = 5; // Bigger fish have a higher value
-    m_powerRequired=6;
-    m_type = AquariumCreatureType::BiggerFish;
-}
-
-void BiggerFish::move() {
-    // Bigger fish might move slower or have different logic
-    m_x += m_dx * (m_speed * 0.5); // Moves at half speed
-    m_y += m_dy * (m_speed * 0.5);
-    if(m_dx < 0 ){
-        this->m_sprite->setFlipped(true);
-    }else {
-        this->m_sprite->setFlipped(false);
-    }
-
-    bounce();
-}
-
-void BiggerFish::draw() const {
-    ofLogVerbose() << "BiggerFish at (" << m_x << ", " << m_y << ") with speed " << m_speed << std::endl;
-    this->m_sprite->draw(this->m_x, this->m_y);
-}
-GyaradosFish::GyaradosFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-: NPCreature(x, y, speed, sprite) {
-    m_value = 10;
-    m_type = AquariumCreatureType::GyaradosFish;
-    m_powerRequired=10;
-}
-
-void GyaradosFish::move(std::shared_ptr<PlayerCreature> player) {
-    float dx = player->getX() - m_x;
-    float dy = player->getY() - m_y;
-    float length = sqrt(dx*dx + dy*dy);
-
-    
-    if (length > 0) { 
-         if (dx < 0) {
-           this-> m_sprite->setFlipped(true);
-        } else {
-            this->m_sprite->setFlipped(false);
-        }
-        m_x += (dx/length) * (m_speed * 1.2f);
-        m_y += (dy/length) * (m_speed * 1.2f);
-    }
-    bounce();
-}
-
-void GyaradosFish::draw() const {
-    m_sprite->draw(m_x, m_y);
-}
+#include <algorithm>
+#include <cstdio>
+#include "sim/JobSystem.h"
 
 
 // AquariumSpriteManager
-AquariumSpriteManager::AquariumSpriteManager(){
-    this->m_npc_fish = std::make_shared<GameSprite>("base-fish.png", 70,70);
-    this->m_big_fish = std::make_shared<GameSprite>("bigger-fish.png", 120, 120);
-    this->m_powerup= std::make_shared<GameSprite>("devil_Fruit.png", 40, 40);
-    this->m_speed_fruit= std::make_shared<GameSprite>("kizaru_Fruit.png",40,40);
-    this->m_omanyte=std::make_shared<GameSprite>("omanyte.png",80,80);
-    this->m_gyarados_fish=std::make_shared<GameSprite>("gyarados.png", 140, 140);
-    this->m_angler_fish = std::make_shared<GameSprite>("angler_Fish.png", 90, 90);
-}
-
-std::shared_ptr<GameSprite> AquariumSpriteManager::GetSprite(AquariumCreatureType t){
+// every sprite gameplay can ask for is queued here, nothing is loaded mid game
+AquariumSpriteManager::AquariumSpriteManager(AssetLoader& loader){
+    this->m_npc_fish = loader.LoadSprite("base-fish.png", 70,70);
+    this->m_big_fish = loader.LoadSprite("bigger-fish.png", 120, 120);
+    this->m_powerup= loader.LoadSprite("devil_Fruit.png", 40, 40);
+    this->m_speed_fruit= loader.LoadSprite("kizaru_Fruit.png",40,40);
+    this->m_omanyte=loader.LoadSprite("omanyte.png",80,80);
+    this->m_gyarados_fish=loader.LoadSprite("gyarados.png", 140, 140);
+    this->m_angler_fish = loader.LoadSprite("angler_Fish.png", 90, 90);
+    this->m_player_boost = loader.LoadSprite("pez_Espada.png", 100, 100);
+    // the atlas copies pixels, so it waits for the uploads. the loader is
+    // owned next to the manager and only calls back from its Update.
+    loader.WhenLoaded([this](){
+        this->m_atlas.Build({m_npc_fish, m_big_fish, m_powerup, m_speed_fruit, m_omanyte, m_gyarados_fish, m_angler_fish});
+    });
+}
+
+// every creature of a kind shares the one sprite loaded in the constructor
+SpriteHandle AquariumSpriteManager::GetSprite(AquariumCreatureType t){
     switch(t){
         case AquariumCreatureType::BiggerFish:
-            return std::make_shared<GameSprite>(*this->m_big_fish);
+            return this->m_big_fish;
             
         case AquariumCreatureType::NPCreature:
-            return std::make_shared<GameSprite>(*this->m_npc_fish);
+            return this->m_npc_fish;
         case AquariumCreatureType::PowerUp:
-            return std::make_shared<GameSprite>(*this->m_powerup);
+            return this->m_powerup;
         case AquariumCreatureType::SpeedFruit:
-            return std::make_shared<GameSprite>(*this->m_speed_fruit);
+            return this->m_speed_fruit;
         case AquariumCreatureType::GyaradosFish:
-            return std::make_shared<GameSprite>(*this->m_gyarados_fish);
+            return this->m_gyarados_fish;
         case AquariumCreatureType::AnglerFish:
-            return std::make_shared<GameSprite>(*this->m_angler_fish);
+            return this->m_angler_fish;
         case AquariumCreatureType::Omanyte:
-            return std::make_shared<GameSprite>(*this->m_omanyte);
+            return this->m_omanyte;
         default:
             return nullptr;
     }
 }
 
-
-// Aquarium Implementation
-Aquarium::Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager)
-    : m_width(width), m_height(height) {
-        m_sprite_manager =  spriteManager;
-    }
-
-
-
-void Aquarium::addCreature(std::shared_ptr<Creature> creature) {
-    creature->setBounds(m_width - 20, m_height - 20);
-    m_creatures.push_back(creature);
+// the swordfish look, shown while the player's size boost is on
+SpriteHandle AquariumSpriteManager::GetPlayerBoostSprite(){
+    return this->m_player_boost;
 }
 
-void Aquarium::addAquariumLevel(std::shared_ptr<AquariumLevel> level){
-    if(level == nullptr){return;} // guard to not add noise
-    this->m_aquariumlevels.push_back(level);
-}
 
-void Aquarium::update(std::shared_ptr<PlayerCreature> player) {
-    for (auto& creature : m_creatures) {
-        if (creature->getType() == AquariumCreatureType::GyaradosFish || creature->getType() == AquariumCreatureType::AnglerFish){
-        creature->move(player);
-    }else{
-        creature->move();
-        }
-    }
-}
 
-void Aquarium::draw() const {
-    for (const auto& creature : m_creatures) {
-        creature->draw();
-    }
+// AquariumRenderer
+AquariumRenderer::AquariumRenderer(std::shared_ptr<AquariumSpriteManager> spriteManager)
+: m_sprite_manager(std::move(spriteManager)){
+    m_batch.setMode(OF_PRIMITIVE_TRIANGLES);
+    m_batch.setUsage(GL_STREAM_DRAW); // rewritten every frame
 }
 
-
-void Aquarium::removeCreature(std::shared_ptr<Creature> creature) {
-    auto it = std::find(m_creatures.begin(), m_creatures.end(), creature);
-    if (it != m_creatures.end()) {
-        if(creature->getType()!=AquariumCreatureType::PowerUp &&
-            creature->getType() != AquariumCreatureType::SpeedFruit){
-        ofLogVerbose() << "removing creature " << endl;
-        int selectLvl = this->currentLevel % this->m_aquariumlevels.size();
-        this->m_aquariumlevels.at(selectLvl)->ConsumePopulation(creature->getType(), creature->getValue());
-            }
-        m_creatures.erase(it);
-    }
+void AquariumRenderer::DrawCreature(const Creature& creature) const {
+    this->DrawCreature(creature, creature.getX(), creature.getY());
 }
 
-void Aquarium::clearCreatures() {
-    m_creatures.clear();
+void AquariumRenderer::DrawCreature(const Creature& creature, float x, float y) const {
+    APP_LOG_VERBOSE() << AquariumCreatureTypeToString(creature.getType()) << " at (" << x << ", " << y << ") with speed " << creature.getSpeed() << std::endl;
+    SpriteHandle sprite = creature.getSprite();
+    if (!sprite) return;
+    ofSetColor(ofColor::white);
+    sprite->draw(x, y, creature.isFlipped());
 }
 
-std::shared_ptr<Creature> Aquarium::getCreatureAt(int index) {
-    if (index < 0 || size_t(index) >= m_creatures.size()) {
-        return nullptr;
-    }
-    return m_creatures[index];
+void AquariumRenderer::DrawPlayer(const PlayerCreature& player) const {
+    this->DrawPlayer(player, player.getX(), player.getY());
 }
 
-
-
-void Aquarium::SpawnCreature(AquariumCreatureType type) {
-    int x = rand() % this->getWidth();
-    int y = rand() % this->getHeight();
-    int speed = 1 + rand() % 25; // Speed between 1 and 25
-
-    switch (type) {
-        case AquariumCreatureType::NPCreature:
-            this->addCreature(std::make_shared<NPCreature>(x, y, speed, this->m_sprite_manager->GetSprite(AquariumCreatureType::NPCreature)));
-            break;
-        case AquariumCreatureType::BiggerFish:
-            this->addCreature(std::make_shared<BiggerFish>(x, y, speed, this->m_sprite_manager->GetSprite(AquariumCreatureType::BiggerFish)));
-            break;
-        case AquariumCreatureType::PowerUp:
-            this->addCreature(std::make_shared<PowerUp>(x, y, this->m_sprite_manager->GetSprite(AquariumCreatureType::PowerUp)));
-            break;
-        case AquariumCreatureType::SpeedFruit:
-            this->addCreature(std::make_shared<SpeedFruit>(x, y, this->m_sprite_manager->GetSprite(AquariumCreatureType::SpeedFruit)));
-            break;
-        case AquariumCreatureType::GyaradosFish:
-            this->addCreature(std::make_shared<GyaradosFish>(x, y, speed, this->m_sprite_manager->GetSprite(type)));
-            break;
-        case AquariumCreatureType::AnglerFish:
-            this->addCreature(std::make_shared<AnglerFish>(x, y, speed, this->m_sprite_manager->GetSprite(AquariumCreatureType::AnglerFish)));
-             break;
-        case AquariumCreatureType::Omanyte:
-            this->addCreature(std::make_shared<AnglerFish>(x, y, speed, this->m_sprite_manager->GetSprite(AquariumCreatureType::Omanyte)));
-             break;
-        default:
-            ofLogError() << "Unknown creature type to spawn!";
-            break;
+void AquariumRenderer::DrawPlayer(const PlayerCreature& player, float x, float y) const {
+    APP_LOG_VERBOSE() << "PlayerCreature at (" << x << ", " << y << ") with speed " << player.getSpeed() << std::endl;
+    SpriteHandle sprite = this->GetPlayerSprite(player);
+    if (player.isInDamageDebounce()) {
+        ofSetColor(ofColor::red); // Flash red if in damage debounce
     }
-
+    if (sprite) {
+        sprite->draw(x, y, player.isFlipped());
+    }
+    ofSetColor(ofColor::white); // Reset color
 }
 
-
-// repopulation will be called from the levl class
-// it will compose into aquarium so eating eats frm the pool of NPCs in the lvl class
-// once lvl criteria met, we move to new lvl through inner signal asking for new lvl
-// which will mean incrementing the buffer and pointing to a new lvl index
-// En Aquarium.cpp - ACTUALIZA el método Repopulate:
-
-void Aquarium::Repopulate(std::shared_ptr<PlayerCreature> player) {
-    ofLogVerbose("entering phase repopulation");
-    
-    int selectedLevelIdx = this->currentLevel % this->m_aquariumlevels.size();
-    ofLogVerbose() << "the current index: " << selectedLevelIdx << endl;
-    std::shared_ptr<AquariumLevel> level = this->m_aquariumlevels.at(selectedLevelIdx);
-
-    int previousWave=level->getCurrentWave();
-    level->update(1.0f/60.0f,player); 
-
-    
-    if (level->getCurrentWave() > previousWave && level->getCurrentWave() < level->getMaxWaves()) {
-    ofLogNotice() << "Nueva wave: " << level->getCurrentWave();
-    level->spawnWave(shared_from_this());
-    return;
-    } 
-    if (level->getCurrentWave() >=level->getMaxWaves() -1) {
-        if (level->getWaveTimer() >= level->getTimeBetweenWaves() *2.0f) {
-            level->forceFinishLevel();
-
-            // return;
+SpriteHandle AquariumRenderer::GetPlayerSprite(const PlayerCreature& player) const {
+    return player.isSizeBoostActive() ? m_sprite_manager->GetPlayerBoostSprite() : player.getSprite();
+}
+
+// AquariumCamera
+void AquariumCamera::Follow(float x, float y, float viewWidth, float viewHeight, float worldWidth, float worldHeight) {
+    // one axis: centered on the target, clamped to the world
+    auto place = [](float target, float view, float world) {
+        if (world <= view) return (world - view) * 0.5f;
+        return std::min(std::max(target - view * 0.5f, 0.0f), world - view);
+    };
+    m_left = place(x, viewWidth, worldWidth);
+    m_top = place(y, viewHeight, worldHeight);
+    m_right = m_left + viewWidth;
+    m_bottom = m_top + viewHeight;
+}
+
+void AquariumCamera::Begin() const {
+    ofPushMatrix();
+    ofTranslate(-m_left, -m_top);
+}
+
+void AquariumCamera::End() const {
+    ofPopMatrix();
+}
+
+// Packs every creature into one vertex buffer over the sprite atlas so the whole
+// population costs a single texture bind and draw call. Facing left just swaps
+// the u coordinates. Creatures whose sprite isn't in the atlas draw one by one.
+// Anything off screen is skipped before it costs a vertex, the check is a few
+// compares per creature straight on the store arrays.
+void AquariumRenderer::DrawAquarium(const Aquarium& aquarium, const AquariumCamera& camera, float alpha) {
+    const SpriteAtlas& atlas = m_sprite_manager->GetAtlas();
+    std::vector<ofDefaultVertexType>& vertices = m_batch.getVertices();
+    std::vector<ofDefaultTexCoordType>& texCoords = m_batch.getTexCoords();
+    vertices.clear();
+    texCoords.clear();
+
+    // read straight from the aquarium's store, slot i is getCreatures()[i]
+    const CreatureStore& store = aquarium.getStore();
+    for (size_t i = 0; i < store.size(); ++i) {
+        const GameSprite* sprite = store.sprite[i].get();
+        if (sprite == nullptr) continue;
+        float x0 = store.prevX[i] + (store.x[i] - store.prevX[i]) * alpha;
+        float y0 = store.prevY[i] + (store.y[i] - store.prevY[i]) * alpha;
+        if (!camera.IsVisible(x0, y0, sprite->getWidth(), sprite->getHeight())) continue;
+        const SpriteAtlasRegion* region = atlas.GetRegion(sprite);
+        if (region == nullptr) {
+            this->DrawCreature(*aquarium.getCreatures()[i], x0, y0);
+            continue;
         }
+        float x1 = x0 + region->width;
+        float y1 = y0 + region->height;
+        float u0 = store.flipped[i] ? region->uv1.x : region->uv0.x;
+        float u1 = store.flipped[i] ? region->uv0.x : region->uv1.x;
+
+        vertices.emplace_back(x0, y0, 0);
+        vertices.emplace_back(x1, y0, 0);
+        vertices.emplace_back(x1, y1, 0);
+        vertices.emplace_back(x0, y1, 0);
+        texCoords.emplace_back(u0, region->uv0.y);
+        texCoords.emplace_back(u1, region->uv0.y);
+        texCoords.emplace_back(u1, region->uv1.y);
+        texCoords.emplace_back(u0, region->uv1.y);
+    }
+
+    // the index pattern only depends on how many quads there are
+    size_t quads = vertices.size() / 4;
+    if (quads != m_batchQuads) {
+        std::vector<ofIndexType>& indices = m_batch.getIndices();
+        size_t filled = std::min(quads, m_batchQuads);
+        indices.resize(quads * 6);
+        for (size_t i = filled; i < quads; ++i) {
+            ofIndexType base = i * 4;
+            ofIndexType* quad = &indices[i * 6];
+            quad[0] = base; quad[1] = base + 1; quad[2] = base + 2;
+            quad[3] = base; quad[4] = base + 2; quad[5] = base + 3;
+        }
+        m_batchQuads = quads;
     }
+    if (quads == 0) return;
 
-    if(level->isCompleted()){
-        ofLogNotice() << "Level " << selectedLevelIdx << " completed! Moving to next level.";
-        cout << "Level is complete!" << endl;
-        level->levelReset();
-        this->currentLevel += 1;
-        selectedLevelIdx = this->currentLevel % this->m_aquariumlevels.size();
-        level = this->m_aquariumlevels.at(selectedLevelIdx);
-        level->initialize(); 
-        this->clearCreatures();
-        this->SpawnCreature(AquariumCreatureType::Omanyte);
-        level->spawnWave(shared_from_this());
-        ofLogNotice() << level->getLevelDescription();
-    }
-
-    
-    std::vector<AquariumCreatureType> toRespawn = level->Repopulate();
-    ofLogVerbose() << "amount to repopulate : " << toRespawn.size() << endl;
-    
-    for(AquariumCreatureType newCreatureType : toRespawn){
-        this->SpawnCreature(newCreatureType);
-    }
-    
+    ofSetColor(ofColor::white);
+    atlas.bind();
+    m_batch.draw();
+    atlas.unbind();
 }
 
 
-// Aquarium collision detection
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player) {
-    if (!aquarium || !player) return nullptr;
-    
-    for (int i = 0; i < aquarium->getCreatureCount(); ++i) {
-        std::shared_ptr<Creature> npc = aquarium->getCreatureAt(i);
-        if (npc && checkCollision(player, npc)) {
-            return std::make_shared<GameEvent>(GameEventType::COLLISION, player, npc);
-        }
-    }
-    return nullptr;
-};
-
 //  Imlementation of the AquariumScene
 
+// the simulation's worker pool starts its threads on first use, get that
+// out of the way on the title screen rather than on the first tick
+void AquariumGameScene::Preload(){
+    SimJobSystem();
+}
+
+// runs as many fixed ticks as the real time since the last frame covers, so
+// the game plays at the same speed whatever the frame rate
 void AquariumGameScene::Update(){
-    std::shared_ptr<GameEvent> event;
-
-    this->m_player->update();
-
-    if (this->updateControl.tick()) {
-        event = DetectAquariumCollisions(this->m_aquarium, this->m_player);
-        if (event != nullptr && event->isCollisionEvent()) {
-            if (event->creatureB->getType() == AquariumCreatureType::PowerUp) {
-            m_player->activateSizeBoost();
-            m_aquarium->removeCreature(event->creatureB);
-             return;
-            }
-        if (event->creatureB->getType() == AquariumCreatureType::SpeedFruit) {
-            m_player->activateSpeedFruit();
-            m_aquarium->removeCreature(event->creatureB);
-             return;
-                }
-        if (event->creatureB->getType() == AquariumCreatureType::Omanyte){
-            m_player->addLife(1);
-            m_aquarium->removeCreature(event->creatureB);
-            ofLogNotice() << "Omanyte eaten! +1 life";
-            return;
-            }
-            ofLogVerbose() << "Collision detected between player and NPC!" << std::endl;
-            float newDx = -m_player->getDx();
-            float newDy= -m_player->getDy();
-            m_player->setDirection(newDx,newDy);
-            if(event->creatureB != nullptr){
-                event->print();
-                if(this->m_player->getPower() < event->creatureB->getPowerRequired()){
-                    ofLogNotice() << "Player is too weak to eat the creature!" << std::endl;
-                    this->m_player->loseLife(3*60); // 3 frames debounce, 3 seconds at 60fps
-                    if(this->m_player->getLives() <= 0){
-                        this->m_lastEvent = std::make_shared<GameEvent>(GameEventType::GAME_OVER, this->m_player, nullptr);
-                        return;
-                    }
-                }
-                else{
-                    this->m_aquarium->removeCreature(event->creatureB);
-                    this->m_player->addToScore(1, event->creatureB->getValue());
-                    if (this->m_player->getScore() % 20 == 0) {
-                        this->m_aquarium->SpawnCreature(AquariumCreatureType::PowerUp);
-                            ofLogNotice() << "A Grow-Grow Devil Fruit appear! ";
-                            }
-                    if (this->m_player->getScore() % 15 == 0) {
-                         this->m_aquarium->SpawnCreature(AquariumCreatureType::SpeedFruit);
-                            ofLogNotice() << "A Light-Speed Devil Fruit appeared!";
-    }
-                        if (this->m_player->getScore() % 10 == 0 && this->m_player->getScore() > 0) {
-                            this->m_player->increasePower(1);
-           
-                    ofLogNotice() << "Player grew stronger! New Power: " << this->m_player->getPower() << endl;
-                    }
-                    
-                }
-                
-                
-
-            } else {
-                ofLogError() << "Error: creatureB is null in collision event." << std::endl;
-            }
+    this->m_profiler.NextFrame();
+    int ticks = this->m_replaying ? (this->IsReplayFinished() ? 0 : 1) : this->m_clock.advance(ofGetLastFrameTime());
+    for (int i = 0; i < ticks; ++i) {
+        this->m_simulation.Tick();
+        if (this->GetLastEvent() != nullptr && this->GetLastEvent()->isGameOver()) {
+            break;
         }
-        this->m_aquarium->update(this->m_player);
-        this->m_aquarium->Repopulate(this->m_player);
     }
-
 }
 
 void AquariumGameScene::Draw() {
-    this->m_player->draw();
-    this->m_aquarium->draw();
-    this->paintAquariumHUD();
+    {
+        ProfileScope scope(&this->m_profiler, ProfilePhase::Draw);
+        float alpha = this->m_replaying ? 1.0f : this->m_clock.getAlpha();
+        std::shared_ptr<PlayerCreature> player = this->GetPlayer();
+        std::shared_ptr<Aquarium> aquarium = this->GetAquarium();
+        float playerX = this->m_simulation.GetPlayerDrawX(alpha);
+        float playerY = this->m_simulation.GetPlayerDrawY(alpha);
+        SpriteHandle playerSprite = this->m_renderer.GetPlayerSprite(*player);
+        float centerX = playerX + (playerSprite ? playerSprite->getWidth() * 0.5f : 0.0f);
+        float centerY = playerY + (playerSprite ? playerSprite->getHeight() * 0.5f : 0.0f);
+        this->m_camera.Follow(centerX, centerY, ofGetWindowWidth(), ofGetWindowHeight(), aquarium->getWidth(), aquarium->getHeight());
+        this->m_camera.Begin();
+        this->m_renderer.DrawPlayer(*player, playerX, playerY);
+        this->m_renderer.DrawAquarium(*aquarium, this->m_camera, this->m_simulation.GetAquariumAlpha(alpha));
+        this->m_camera.End();
+    }
+    {
+        ProfileScope scope(&this->m_profiler, ProfilePhase::Hud);
+        this->paintAquariumHUD();
+    }
+    if (this->m_profiler.IsEnabled()) {
+        this->paintProfilerOverlay();
+    }
 
 }
 
@@ -492,12 +228,13 @@ void AquariumGameScene::Draw() {
 
 
 void AquariumGameScene::paintAquariumHUD(){
+    std::shared_ptr<PlayerCreature> player = this->GetPlayer();
     float panelWidth = ofGetWindowWidth() - 150;
-    ofDrawBitmapString("Score: " + std::to_string(m_player->getScore()), panelWidth, 20);
-    ofDrawBitmapString("Power: " + std::to_string(m_player->getPower()), panelWidth, 30);
-    ofDrawBitmapString("Lives: " + std::to_string(m_player->getLives()), panelWidth, 40);
+    ofDrawBitmapString("Score: " + std::to_string(player->getScore()), panelWidth, 20);
+    ofDrawBitmapString("Power: " + std::to_string(player->getPower()), panelWidth, 30);
+    ofDrawBitmapString("Lives: " + std::to_string(player->getLives()), panelWidth, 40);
     
-    auto aquarium=m_aquarium;
+    auto aquarium=this->GetAquarium();
 
         int levelCount =aquarium->getLevelCount();
         int currentLevelIdx =aquarium->getCurrentLevelIndex();
@@ -513,266 +250,50 @@ void AquariumGameScene::paintAquariumHUD(){
         ofDrawBitmapString(level->getLevelDescription(), 20, ofGetWindowHeight() - 20);
     }
     
-    for (int i = 0; i <m_player->getLives(); ++i) {
+    for (int i = 0; i <player->getLives(); ++i) {
         ofSetColor(ofColor::red);
         ofDrawCircle(panelWidth + i * 20, 50, 5);
     }
     ofSetColor(ofColor::white);
 }
 
-void AquariumLevel::initialize() {
-    m_level_score = 0;
-    m_currentWave = 0;
-    m_waveTimer = 0.0f;
-    m_levelCompleted = false;
-    populationReset();
-    setupWavePattern();
-}
-void AquariumLevel::update(float deltaTime, std::shared_ptr<PlayerCreature> player) {
-   
-    if (m_levelCompleted) return;
-
-    
-    m_waveTimer += deltaTime;
-
-    
-    if (m_currentWave +1< m_maxWaves && m_waveTimer >= m_timeBetweenWaves) {
-        ofLogNotice() << "[Wave Change] Jumping from wave " << m_currentWave
-                  << " to wave " << (m_currentWave + 1);
-
-        m_waveTimer = 0.0f;
-        m_currentWave++;
-    }
+// Top left panel: average ms per phase over the last few seconds, frame time
+// percentiles and a graph of recent frame times (line at 60 fps)
+void AquariumGameScene::paintProfilerOverlay(){
+    const FrameProfiler& profiler = this->m_profiler;
+    const float left = 10;
+    const float lineHeight = 12;
+    float y = 20;
+    char line[96];
 
-    
-    if (m_level_score >= m_targetScore) {
-        m_levelCompleted = true;
-    }
-}
-
-void AquariumLevel::spawnWave(std::shared_ptr<Aquarium> aquarium) {
-    if (!aquarium) return;
-    
-    std::vector<AquariumCreatureType> waveCreatures = getWaveCreatures(m_currentWave);
-    for (auto creatureType : waveCreatures) {
-        aquarium->SpawnCreature(creatureType);
-    }
-}
-std::vector<AquariumCreatureType> AquariumLevel::Repopulate() {
-    std::vector<AquariumCreatureType> toRepopulate;
-
-    if (m_currentWave >= m_maxWaves) {
-        for (auto& node : m_levelPopulation) {
-            int counter1 = node->population - node->currentPopulation;
-            if (counter1 > 0) {
-                for (int i = 0; i < counter1; i++) {
-                    toRepopulate.push_back(node->creatureType);
-                }
-                node->currentPopulation += counter1;
-            }
-        }
-    }
-    return toRepopulate;
-}
-
-
-
-void AquariumLevel::populationReset(){
-    for(auto node: this->m_levelPopulation){
-        node->currentPopulation = 0; // need to reset the population to ensure they are made a new in the next level
-    }
-}
-
-void AquariumLevel::ConsumePopulation(AquariumCreatureType creatureType, int power){
-    for(std::shared_ptr<AquariumLevelPopulationNode> node: this->m_levelPopulation){
-        ofLogVerbose() << "consuming from this level creatures" << endl;
-        if(node->creatureType == creatureType){
-            ofLogVerbose() << "-cosuming from type: " << AquariumCreatureTypeToString(node->creatureType) <<" , currPop: " << node->currentPopulation << endl;
-            if(node->currentPopulation > 0){
-                node->currentPopulation -= 1;
-            }
-                m_level_score += power;
-                
-
-             
-            
-            ofLogVerbose() << "+cosuming from type: " << AquariumCreatureTypeToString(node->creatureType) <<" , currPop: " << node->currentPopulation << endl;
-            if(m_level_score >= m_targetScore) {
-                    m_levelCompleted = true;
-                }
-            }
-            return;
-        }
-    }
-   
-
-
-bool AquariumLevel::isCompleted() {
-   return m_levelCompleted || m_level_score >= m_targetScore;
-//    return this-> m_level_score >=this-> m_targetScore;
-}
-
-
-
-
-
-void Level_0::setupWavePattern() {
-    m_maxWaves = 3;
-    m_timeBetweenWaves = 2.0f;
-}
-
-std::vector<AquariumCreatureType> Level_0::getWaveCreatures(int waveNumber) {
-    std::vector<AquariumCreatureType> waveCreatures;
-    
-    switch(waveNumber) {
-        case 0: 
-            for(int i = 0; i < 4; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            break;
-        case 1: 
-            for(int i = 0; i < 6; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            break;
-        case 2: 
-            for(int i = 0; i < 4; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-
-        waveCreatures.push_back(AquariumCreatureType::AnglerFish);
-    break;
-    }
-    
-    return waveCreatures;
-}
-
-std::string Level_0::getLevelDescription() const {
-    return "Nivel 1: Ecosistema Basico - Peces Dorados Pacificos";
-}
-
-
-void Level_1::setupWavePattern() {
-    m_maxWaves = 4;
-    m_timeBetweenWaves = 2.0f;
-}
-
-std::vector<AquariumCreatureType> Level_1::getWaveCreatures(int waveNumber) {
-    std::vector<AquariumCreatureType> waveCreatures;
-    
-    switch(waveNumber) {
-        case 0: 
-            for(int i = 0; i < 4; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            break;
-        case 1: 
-            for(int i = 0; i < 3; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            }
-            break;
-        case 2: 
-            for(int i = 0; i < 5; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            }
-            waveCreatures.push_back(AquariumCreatureType::GyaradosFish);
-            break;
-        case 3: 
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::GyaradosFish);
-            }
-            break;
-    }
-    
-    return waveCreatures;
-}
-
-std::string Level_1::getLevelDescription() const {
-    return "Nivel 2: Arrecife de Coral - Aparecen Gyarados!";
-}
-
-
-
-void Level_2::setupWavePattern() {
-    m_maxWaves = 5;
-    m_timeBetweenWaves = 2.0f;
-}
-
-std::vector<AquariumCreatureType> Level_2::getWaveCreatures(int waveNumber) {
-    std::vector<AquariumCreatureType> waveCreatures;
-    
-    switch(waveNumber) {
-        case 0: 
-            for(int i = 0; i < 3; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            waveCreatures.push_back(AquariumCreatureType::AnglerFish);
-            break;
-        case 1: 
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            }
-            waveCreatures.push_back(AquariumCreatureType::GyaradosFish);
-            break;
-        case 2: 
-            waveCreatures.push_back(AquariumCreatureType::NPCreature);
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::AnglerFish);
-            }
-            break;
-        case 3: 
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::BiggerFish);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::GyaradosFish);
-            }
-            for(int i = 0; i < 2; i++) {
-                waveCreatures.push_back(AquariumCreatureType::AnglerFish);
-            }
-            break;
-        case 4: 
-            for(int i = 0; i < 3; i++) {
-                waveCreatures.push_back(AquariumCreatureType::GyaradosFish);
-            }
-            for(int i = 0; i < 3; i++) {
-                waveCreatures.push_back(AquariumCreatureType::AnglerFish);
-            }
-            break;
-    }
-    
-    return waveCreatures;
-}
-
-std::string Level_2::getLevelDescription() const {
-    return "Nivel 3: Oceano Profundo - Peligros y Maravillas!";
-}
-void Level_0::spawnWave(std::shared_ptr<Aquarium> aquarium){
-     ofLogNotice() << "[Spawner] Level 0 spawneando wave " << m_currentWave;
-    AquariumLevel::spawnWave(aquarium);
-}
-
-void Level_1::spawnWave(std::shared_ptr<Aquarium> aquarium){
-    AquariumLevel::spawnWave(aquarium);
+    ofSetColor(0, 0, 0, 160);
+    ofDrawRectangle(left - 5, y - 12, 260, lineHeight * (FrameProfiler::PHASES + 3) + 75);
+    ofSetColor(ofColor::white);
+    for (size_t i = 0; i < FrameProfiler::PHASES; ++i) {
+        ProfilePhase phase = ProfilePhase(i);
+        std::snprintf(line, sizeof(line), "%-16s %7.3f ms", ProfilePhaseToString(phase), profiler.GetPhaseAverageMs(phase));
+        ofDrawBitmapString(line, left, y);
+        y += lineHeight;
+    }
+    std::snprintf(line, sizeof(line), "creatures        %7d", this->GetAquarium()->getCreatureCount());
+    ofDrawBitmapString(line, left, y);
+    y += lineHeight;
+    std::snprintf(line, sizeof(line), "frame p50 %6.2f ms  p99 %6.2f ms",
+                  profiler.GetFramePercentileMs(0.5), profiler.GetFramePercentileMs(0.99));
+    ofDrawBitmapString(line, left, y);
+    y += lineHeight;
+
+    // 0..33 ms mapped onto 60 px, anything slower is clipped at the top
+    const float graphHeight = 60;
+    const float graphBottom = y + graphHeight;
+    const float msToPixels = graphHeight / 33.3f;
+    size_t frames = profiler.GetFrameCount();
+    for (size_t i = 0; i < frames; ++i) {
+        float height = std::min((float)profiler.GetFrameMs(i) * msToPixels, graphHeight);
+        ofSetColor(height > 16.7f * msToPixels ? ofColor::red : ofColor::green);
+        ofDrawLine(left + i, graphBottom, left + i, graphBottom - height);
+    }
+    ofSetColor(ofColor::yellow);
+    ofDrawLine(left, graphBottom - 16.7f * msToPixels, left + FrameProfiler::HISTORY, graphBottom - 16.7f * msToPixels);
+    ofSetColor(ofColor::white);
 }
-
-void Level_2::spawnWave(std::shared_ptr<Aquarium> aquarium){
-    AquariumLevel::spawnWave(aquarium);
-}
\ No newline at end of file
@@ -5,342 +5,114 @@
 #include <iostream>
 #include <algorithm>
 #include "Core.h"
+#include "sim/AquariumSim.h"
 
 
-enum class AquariumCreatureType {
-    Player,
-    NPCreature,
-    BiggerFish,
-    PowerUp,
-    SpeedFruit,
-    GyaradosFish,
-    AnglerFish,
-    Omanyte
-};
-
-string AquariumCreatureTypeToString(AquariumCreatureType t);
+// Rendering side of the aquarium. Everything the game simulates lives in
+// sim/AquariumSim.h, this file only loads sprites and paints the result.
 
-class AquariumLevelPopulationNode{
+class AquariumSpriteManager : public CreatureSpriteSource {
     public:
-        AquariumLevelPopulationNode() = default;
-        AquariumLevelPopulationNode(AquariumCreatureType creature_type, int population) {
-            this->creatureType = creature_type;
-            this->population = population;
-            this->currentPopulation = 0;
-        };
-        AquariumCreatureType creatureType;
-        int population;
-        int currentPopulation;
-};
-class Aquarium;
-class AquariumLevel;
-class AquariumLevel : public GameLevel {
-    
-
-    protected:
-        std::vector<std::shared_ptr<AquariumLevelPopulationNode>> m_levelPopulation;
-        int m_level_score;
-        int m_targetScore;
-        int m_currentWave;
-        int m_maxWaves;
-        float m_timeBetweenWaves;
-        float m_waveTimer;
-        bool m_levelCompleted;
-        virtual void setupWavePattern() = 0;
-        virtual std::vector<AquariumCreatureType> getWaveCreatures(int waveNumber) = 0;
-    
+        explicit AquariumSpriteManager(AssetLoader& loader);
+        ~AquariumSpriteManager() = default;
+        SpriteHandle GetSprite(AquariumCreatureType t) override;
+        SpriteHandle GetPlayerBoostSprite();
+        const SpriteAtlas& GetAtlas() const { return m_atlas; }
+    private:
+        SpriteHandle m_npc_fish;
+        SpriteHandle m_big_fish;
+        SpriteHandle m_powerup;
+        SpriteHandle m_speed_fruit;
+        SpriteHandle m_omanyte;
+        SpriteHandle m_gyarados_fish;
+        SpriteHandle m_angler_fish;
+        SpriteHandle m_player_boost;
+        SpriteAtlas m_atlas; // every creature sprite, for the batched aquarium draw
+};
+
+
+// The window's view of a world that can be much bigger than it. Follow
+// centers the view on a point and keeps it inside the world, a world smaller
+// than the window sits in the middle of it. Draw world space between
+// Begin and End.
+class AquariumCamera {
     public:
-        AquariumLevel(int levelNumber, int targetScore)
-        : GameLevel(levelNumber), m_level_score(0), m_targetScore(targetScore){};
-        void ConsumePopulation(AquariumCreatureType creature, int power);
-        bool isCompleted() override;
-        void populationReset();
-        void levelReset(){m_level_score=0;this->populationReset();}
-        virtual std::vector<AquariumCreatureType> Repopulate();
-        virtual void initialize();
-        virtual void update(float deltaTime, std::shared_ptr<PlayerCreature> player);
-        virtual void spawnWave(std::shared_ptr<Aquarium> aquarium);
-        int getCurrentWave() const { return m_currentWave; }
-        int getMaxWaves() const { return m_maxWaves; }
-        virtual std::string getLevelDescription() const = 0;
-
-        float getWaveTimer() const{return m_waveTimer;}
-        float getTimeBetweenWaves() const{return m_timeBetweenWaves;}
-        int getLevelScore() const{return m_level_score;}
-        int getTargetScore() const{return m_targetScore;}
-        void forceAdvanceWave() {
-            m_waveTimer = 0.0f;
-            m_currentWave++;
-            ofLogNotice() << "Nueva wave -> " << m_currentWave;
-        }
-        void forceFinishLevel() {
-            m_levelCompleted = true;
-        }
-
-};
-
-
-class PlayerCreature : public Creature {
-public:
-
-    PlayerCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move();
-    void draw() const;
-    void update();
-    void changeSpeed(int speed);
-    void setLives(int lives) { m_lives = lives; }
-    void setDirection(float dx, float dy);
-    float isXDirectionActive() { return m_dx != 0; }
-    float isYDirectionActive() {return m_dy != 0; }
-    float getDx() { return m_dx; }
-    float getDy() { return m_dy; }
-
-    int getScore()const { return m_score; }
-    int getLives() const { return m_lives; }
-    int getPower() const { return m_power; }
-    
-    void addToScore(int amount, int weight=1) { m_score += amount * weight; }
-    void loseLife(int debounce);
-    void increasePower(int value) { m_power += value; }
-    void reduceDamageDebounce();
-    void activateSizeBoost();
-    void updateSizeBoost();
-    void activateSpeedFruit();
-    void updateSpeedFruit();
-    void addLife(int amount = 1){
-        if (m_lives <3){
-            m_lives += amount;
-            if (m_lives >3) m_lives =3;
-            ofLogNotice() << "Player gained a life!" << endl;
-        } else{
-            ofLogNotice() << "Lives are already at the maximum!"<<endl;
+        void Follow(float x, float y, float viewWidth, float viewHeight, float worldWidth, float worldHeight);
+        void Begin() const;
+        void End() const;
+        // whether a w x h rectangle at (x, y) in the world shows on screen
+        bool IsVisible(float x, float y, float w, float h) const {
+            return x < m_right && x + w > m_left && y < m_bottom && y + h > m_top;
         }
-    }
-    
-private:
-    int m_score = 0;
-    int m_lives = 3;
-    int m_power = 1; // mark current power lvl
-    int m_damage_debounce = 0; // frames to wait after eating
-    bool m_sizeActive=false;
-    float m_sizeScale=1.0;
-    int m_sizeTimer=0;
-    const int m_sizeDuration= 15*60;
-    float m_defaultCollisionRad=25.0;
-    std::shared_ptr<GameSprite> m_powerupSprite;
-    std::shared_ptr<GameSprite> m_normalSprite;
-    bool m_speedFruitActive=false;
-    int m_speedFruitTime=0;
-    const int m_speedFruitDuration=7*60;
-    int m_speedNormal=0;
-};
-class NPCreature : public Creature {
-public:
-    NPCreature(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    AquariumCreatureType GetType() {return this->m_creatureType;}
-    void move() override;
-    void draw() const override;
-
-    int getValue() const{return m_value;}
-    int getPowerRequired() const {return m_powerRequired;}
-protected:
-    AquariumCreatureType m_creatureType;
-};
-
-class BiggerFish : public NPCreature {
-public:
-    BiggerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move() override;
-    void draw() const override;
-};
-class GyaradosFish : public NPCreature {
-    public:
-    GyaradosFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite);
-    void move(std::shared_ptr<PlayerCreature> player) override;
-    void draw() const override;
-};
-class PowerUp : public Creature{
-public:
-    PowerUp(float x, float y, std::shared_ptr<GameSprite> sprite)
-        : Creature(x, y, 0, 20.0f, 0, sprite)
-    {
-        m_type = AquariumCreatureType::PowerUp;
-    }
-
-    void move() override {};
-    void draw() const override {m_sprite->draw(m_x, m_y);}
-};
-class SpeedFruit : public Creature{
-public:
-    SpeedFruit(float x, float y, std::shared_ptr<GameSprite> sprite)
-        : Creature(x, y, 0, 20.0f, 0, sprite){
-        m_type= AquariumCreatureType::SpeedFruit;
-    }
-    void move() override {}
-    void draw() const override {m_sprite->draw(m_x, m_y);}
-};
-class Omanyte : public NPCreature {
-public:
-    Omanyte(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-        : NPCreature(x, y, speed, sprite)
-    {
-        m_type = AquariumCreatureType::Omanyte;
-        setCollisionRadius(35.0f);
-    }
-    void draw() const override{
-        m_sprite->draw(m_x, m_y);
-    }
+        float GetLeft() const { return m_left; }
+        float GetTop() const { return m_top; }
+    private:
+        float m_left = 0.0f;
+        float m_top = 0.0f;
+        float m_right = 0.0f;
+        float m_bottom = 0.0f;
 };
-class AnglerFish : public NPCreature{
-    public:
-    AnglerFish(float x, float y, int speed, std::shared_ptr<GameSprite> sprite)
-        : NPCreature(x, y, speed, sprite) {
-        m_value = 4;
-        m_type = AquariumCreatureType::AnglerFish;
-        m_powerRequired=2;
-    }
-
-  void move(std::shared_ptr<PlayerCreature> player) {
-        float dx = player->getX() - m_x;
-        float dy = player->getY() - m_y;
-        float distancia = sqrt(dx*dx + dy*dy);
 
-        if (distancia < 150) {  
-            m_dx = -dx/distancia;
-            m_dy = -dy/distancia;
-            m_x += m_dx* (m_speed*1.6f);
-            m_y += m_dy* (m_speed*1.6f);
-        } else {
-        m_x += m_dx * m_speed;
-        m_y += m_dy * m_speed;
-        }
-         if (m_dx < 0) {
-            this->m_sprite->setFlipped(true);
-        } else {
-            this->m_sprite->setFlipped(false);
-        }
-        bounce();
-    }
-    void draw() const override {
-        m_sprite->draw(m_x, m_y);
-    }
-};
 
-class AquariumSpriteManager {
+class AquariumRenderer {
     public:
-        AquariumSpriteManager();
-        ~AquariumSpriteManager() = default;
-        std::shared_ptr<GameSprite>GetSprite(AquariumCreatureType t);
+        AquariumRenderer(std::shared_ptr<AquariumSpriteManager> spriteManager);
+        void DrawCreature(const Creature& creature) const;
+        void DrawCreature(const Creature& creature, float x, float y) const;
+        void DrawPlayer(const PlayerCreature& player) const;
+        void DrawPlayer(const PlayerCreature& player, float x, float y) const;
+        // what DrawPlayer shows: the boost sprite while the size boost lasts
+        SpriteHandle GetPlayerSprite(const PlayerCreature& player) const;
+        // alpha blends every creature from its position before the last
+        // Aquarium::update (0) to the current one (1). Only creatures the
+        // camera sees are submitted.
+        void DrawAquarium(const Aquarium& aquarium, const AquariumCamera& camera, float alpha = 1.0f);
     private:
-        std::shared_ptr<GameSprite> m_npc_fish;
-        std::shared_ptr<GameSprite> m_big_fish;
-        std::shared_ptr<GameSprite> m_powerup;
-        std::shared_ptr<GameSprite> m_speed_fruit;
-        std::shared_ptr<GameSprite> m_omanyte;
-        std::shared_ptr<GameSprite> m_gyarados_fish;
-        std::shared_ptr<GameSprite> m_angler_fish;
-};
-
-
-class Aquarium :public std::enable_shared_from_this<Aquarium>{
-public:
-    Aquarium(int width, int height, std::shared_ptr<AquariumSpriteManager> spriteManager);
-    void addCreature(std::shared_ptr<Creature> creature);
-    void addAquariumLevel(std::shared_ptr<AquariumLevel> level);
-    void removeCreature(std::shared_ptr<Creature> creature);
-    void clearCreatures();
-    void update(std::shared_ptr<PlayerCreature> player);
-    void draw() const;
-    void setBounds(int w, int h) { m_width = w; m_height = h; }
-    void setMaxPopulation(int n) { m_maxPopulation = n; }
-    void Repopulate(std::shared_ptr<PlayerCreature> player);
-    void SpawnCreature(AquariumCreatureType type);
-    
-    std::shared_ptr<Creature> getCreatureAt(int index);
-    int getCreatureCount() const { return m_creatures.size(); }
-    int getWidth() const { return m_width; }
-    int getHeight() const { return m_height; }
-    int getCurrentLevelIndex() const{return currentLevel;}
-    int getLevelCount() const{return m_aquariumlevels.size();}
-    std::shared_ptr<AquariumLevel> getLevel(int index) const{return m_aquariumlevels.at(index); }
-
-private:
-    int m_maxPopulation = 0;
-    int m_width;
-    int m_height;
-    int currentLevel = 0;
-    std::vector<std::shared_ptr<Creature>> m_creatures;
-    std::vector<std::shared_ptr<Creature>> m_next_creatures;
-    std::vector<std::shared_ptr<AquariumLevel>> m_aquariumlevels;
-    std::shared_ptr<AquariumSpriteManager> m_sprite_manager;
+        std::shared_ptr<AquariumSpriteManager> m_sprite_manager;
+        // one quad per creature, rebuilt every frame and drawn with a single call
+        ofVboMesh m_batch;
+        size_t m_batchQuads = 0;
 };
 
 
-std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
-
-
 class AquariumGameScene : public GameScene {
     public:
-        AquariumGameScene(std::shared_ptr<PlayerCreature> player, std::shared_ptr<Aquarium> aquarium, string name)
-        : m_player(std::move(player)) , m_aquarium(std::move(aquarium)), m_name(name){}
-        std::shared_ptr<GameEvent> GetLastEvent(){return m_lastEvent;}
-        void SetLastEvent(std::shared_ptr<GameEvent> event){this->m_lastEvent = event;}
-        std::shared_ptr<PlayerCreature> GetPlayer(){return this->m_player;}
-        std::shared_ptr<Aquarium> GetAquarium(){return this->m_aquarium;}
-        string GetName()override {return this->m_name;}
+        AquariumGameScene(std::shared_ptr<PlayerCreature> player, std::shared_ptr<Aquarium> aquarium,
+                          std::shared_ptr<AquariumSpriteManager> spriteManager)
+        : m_simulation(std::move(player), std::move(aquarium)), m_renderer(std::move(spriteManager)){
+            m_simulation.SetProfiler(&m_profiler);
+        }
+        std::shared_ptr<GameEvent> GetLastEvent(){return m_simulation.GetLastEvent();}
+        void SetLastEvent(std::shared_ptr<GameEvent> event){this->m_simulation.SetLastEvent(event);}
+        std::shared_ptr<PlayerCreature> GetPlayer(){return this->m_simulation.GetPlayer();}
+        std::shared_ptr<Aquarium> GetAquarium(){return this->m_simulation.GetAquarium();}
+        GameSceneKind GetKind() const override {return GameSceneKind::AQUARIUM_GAME;}
+        GameSceneKind GetNextKind() const override {return GameSceneKind::GAME_OVER;}
+        void Preload() override;
+        // simulation ticks per second, independent of the frame rate
+        void SetTickRate(float hz){ this->m_clock.setRate(hz); this->m_simulation.SetTickRate(hz); }
+        // frame timings overlay, off by default
+        FrameProfiler& GetProfiler(){ return this->m_profiler; }
+        void ToggleProfiler(){ this->m_profiler.SetEnabled(!this->m_profiler.IsEnabled()); }
+        // steering keys, recorded when a recorder is set (see AquariumSimulation::PressKey)
+        void PressKey(PlayerKey key, bool pressed){ this->m_simulation.PressKey(key, pressed); }
+        void SetRecorder(InputLog* log){ this->m_simulation.SetRecorder(log); }
+        uint32_t GetTickCount() const { return this->m_simulation.GetTickCount(); }
+        // plays log back one tick per frame, so frames run as fast as they draw
+        void StartReplay(const InputLog* log){ this->m_simulation.SetReplay(log); this->m_replaying = log != nullptr; }
+        bool IsReplayFinished() const { return this->m_simulation.IsReplayFinished(); }
+        // save states, see AquariumSimulation::SaveSnapshot
+        bool SaveSnapshot(const std::string& path) const { return this->m_simulation.SaveSnapshot(path); }
+        bool LoadSnapshot(const std::string& path){ return this->m_simulation.LoadSnapshot(path); }
         void Update() override;
         void Draw() override;
     private:
         void paintAquariumHUD();
-        std::shared_ptr<PlayerCreature> m_player;
-        std::shared_ptr<Aquarium> m_aquarium;
-        std::shared_ptr<GameEvent> m_lastEvent;
-        string m_name;
-        AwaitFrames updateControl{5};
-};
-
-
-class Level_0 : public AquariumLevel  {
-    public:
-        Level_0(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 14));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::AnglerFish, 4));
-        }
-
-
-        void spawnWave(std::shared_ptr<Aquarium> aquarium) override;
-        void setupWavePattern() override;
-        std::vector<AquariumCreatureType> getWaveCreatures(int waveNumber) override;
-        std::string getLevelDescription() const override;
-};
-
-class Level_1 : public AquariumLevel  {
-    public:
-        Level_1(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 9));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 5));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::AnglerFish, 3));
-        }
-
-
-        void spawnWave(std::shared_ptr<Aquarium> aquarium) override;
-        void setupWavePattern() override;
-        std::vector<AquariumCreatureType> getWaveCreatures(int waveNumber) override;
-        std::string getLevelDescription() const override;
-
-};
-class Level_2 : public AquariumLevel  {
-    public:
-        Level_2(int levelNumber, int targetScore): AquariumLevel(levelNumber, targetScore){
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::NPCreature, 6));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::BiggerFish, 8));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::GyaradosFish, 6));
-            this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType::AnglerFish, 6));
-        }
-
-
-        void spawnWave(std::shared_ptr<Aquarium> aquarium) override;
-        void setupWavePattern() override;
-        std::vector<AquariumCreatureType> getWaveCreatures(int waveNumber) override;
-        std::string getLevelDescription() const override;
+        void paintProfilerOverlay();
+        FrameProfiler m_profiler; // before m_simulation, which points at it
+        AquariumSimulation m_simulation;
+        FixedTimestep m_clock;
+        AquariumCamera m_camera;
+        bool m_replaying = false;
+        AquariumRenderer m_renderer;
 };
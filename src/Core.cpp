@@ -1,81 +1,183 @@
 #include "Core.h"
 
 
-// Creature Inherited Base Behavior
-void Creature::setBounds(int w, int h) { m_width = w; m_height = h; }
-void Creature::normalize() {
-    float length = std::sqrt(m_dx * m_dx + m_dy * m_dy);
-    if (length != 0) {
-        m_dx /= length;
-        m_dy /= length;
-    }
-}
-
-void Creature::bounce() {
-    // should implement boundary controls here
-    //Pared izq.
-   if (m_x < m_collisionRadius) {
-        m_x = m_collisionRadius;
-        m_dx = -m_dx;
-    } else if (m_x > m_width - m_collisionRadius) {  //pared der.
-        m_x = m_width - m_collisionRadius;
-        m_dx = -m_dx;
-    }
-
-    if (m_y < m_collisionRadius) { //borde abajo
-        m_y = m_collisionRadius;
-        m_dy = -m_dy;
-    } else if (m_y > m_height - m_collisionRadius) {
-        m_y = m_height - m_collisionRadius;
-        m_dy = -m_dy;
-    } 
-}
-
-
-void GameEvent::print() const {
-        
-        switch (type) {
-            case GameEventType::NONE:
-                ofLogVerbose() << "No event." << std::endl;
-                break;
-            case GameEventType::COLLISION:
-                ofLogVerbose() << "Collision event between creatures at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ") and ("
-                << creatureB->getX() << ", " << creatureB->getY() << ")." << std::endl;
-                break;
-            case GameEventType::CREATURE_ADDED:
-                ofLogVerbose() << "Creature added at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
-                break;
-            case GameEventType::CREATURE_REMOVED:
-                ofLogVerbose() << "Creature removed at (" 
-                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
-                break;
-            case GameEventType::GAME_OVER:
-                ofLogVerbose() << "Game Over event." << std::endl;
-                break;
-            case GameEventType::NEW_LEVEL:
-                ofLogVerbose() << "New Game level" << std::endl;
-            default:
-                ofLogVerbose() << "Unknown event type." << std::endl;
-                break;
+// SpriteAtlas
+// shelf packing: tallest sprites first, left to right, new row when a row fills up
+void SpriteAtlas::Build(const std::vector<SpriteHandle>& sprites) {
+    const int atlasWidth = 1024;
+    const int padding = 2; // keeps linear filtering from bleeding neighbours in
+
+    std::vector<SpriteHandle> sorted;
+    for (const SpriteHandle& sprite : sprites) {
+        if (sprite) sorted.push_back(sprite);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const SpriteHandle& a, const SpriteHandle& b) {
+        return a->getHeight() > b->getHeight();
+    });
+
+    std::vector<std::pair<int, int>> origins;
+    int x = padding;
+    int y = padding;
+    int rowHeight = 0;
+    for (const SpriteHandle& sprite : sorted) {
+        int w = sprite->getWidth();
+        int h = sprite->getHeight();
+        if (x + w + padding > atlasWidth) {
+            x = padding;
+            y += rowHeight + padding;
+            rowHeight = 0;
         }
-};
+        origins.push_back({x, y});
+        x += w + padding;
+        rowHeight = std::max(rowHeight, h);
+    }
+    int atlasHeight = y + rowHeight + padding;
 
-// collision detection between two creatures
-bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b) {
-    if (!a||!b) return false; 
+    ofPixels atlasPixels;
+    atlasPixels.allocate(atlasWidth, atlasHeight, OF_IMAGE_COLOR_ALPHA);
+    atlasPixels.setColor(ofColor(0, 0, 0, 0));
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        ofPixels pixels = sorted[i]->getPixels();
+        pixels.setImageType(OF_IMAGE_COLOR_ALPHA); // pasteInto needs matching channels
+        pixels.pasteInto(atlasPixels, origins[i].first, origins[i].second);
+    }
+    m_texture.allocate(atlasPixels);
+    m_texture.loadData(atlasPixels);
 
-    float fx = a->getX() - b->getX();
-    float fy = a->getY() - b->getY();
-    float distancia = sqrt(fx*fx + fy*fy);
+    m_regions.clear();
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        SpriteAtlasRegion region;
+        region.width = sorted[i]->getWidth();
+        region.height = sorted[i]->getHeight();
+        // getCoordFromPoint handles both ARB (pixel) and normalized texture coordinates
+        region.uv0 = m_texture.getCoordFromPoint(origins[i].first, origins[i].second);
+        region.uv1 = m_texture.getCoordFromPoint(origins[i].first + region.width, origins[i].second + region.height);
+        m_regions.push_back({sorted[i].get(), region});
+    }
+}
 
-    float radiusA = a->getCollisionRadius();
-    float radiusB = b->getCollisionRadius();
+// only a handful of sprites, a linear scan beats hashing here
+const SpriteAtlasRegion* SpriteAtlas::GetRegion(const GameSprite* sprite) const {
+    for (const auto& entry : m_regions) {
+        if (entry.first == sprite) return &entry.second;
+    }
+    return nullptr;
+}
 
-    return distancia < (radiusA+radiusB);
 
-};
+
+// AssetLoader
+AssetLoader::AssetLoader(int workers) {
+    if (workers <= 0) {
+        workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+    for (int i = 0; i < workers; ++i) {
+        m_threads.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+        m_requests.clear(); // nobody will upload them now
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+SpriteHandle AssetLoader::LoadSprite(const std::string& path, int width, int height) {
+    std::shared_ptr<GameSprite> sprite = std::make_shared<GameSprite>(width, height);
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_requests.push_back(Request{path, width, height, sprite});
+    }
+    ++m_requested;
+    m_wake.notify_one();
+    return sprite;
+}
+
+void AssetLoader::WhenLoaded(std::function<void()> callback) {
+    if (this->IsDone()) {
+        callback();
+        return;
+    }
+    m_callbacks.push_back({m_requested, std::move(callback)});
+}
+
+// decoding and resizing are plain CPU work on ofPixels, no GL context needed
+void AssetLoader::workerLoop() {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            m_wake.wait(guard, [this] { return m_stop || !m_requests.empty(); });
+            if (m_stop) return;
+            request = std::move(m_requests.front());
+            m_requests.pop_front();
+        }
+        Decoded decoded{std::move(request.sprite), ofPixels(), request.path, false};
+        decoded.ok = ofLoadImage(decoded.pixels, request.path);
+        if (decoded.ok) {
+            decoded.pixels.resize(request.width, request.height);
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_decoded.push_back(std::move(decoded));
+        }
+        m_decodedSignal.notify_one();
+    }
+}
+
+void AssetLoader::upload(Decoded& decoded) {
+    if (decoded.ok) {
+        decoded.sprite->upload(decoded.pixels);
+    } else {
+        ofLogError() << "Failed to load image: " << decoded.path; // the sprite just stays empty
+    }
+    ++m_uploaded;
+    // callbacks can queue more work, so take the due ones out first
+    std::vector<std::function<void()>> due;
+    for (size_t i = 0; i < m_callbacks.size();) {
+        if (m_callbacks[i].first <= m_uploaded) {
+            due.push_back(std::move(m_callbacks[i].second));
+            m_callbacks.erase(m_callbacks.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+    for (auto& callback : due) {
+        callback();
+    }
+}
+
+void AssetLoader::Update(int maxUploads) {
+    for (int i = 0; i < maxUploads; ++i) {
+        Decoded decoded;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_decoded.empty()) return;
+            decoded = std::move(m_decoded.front());
+            m_decoded.pop_front();
+        }
+        this->upload(decoded);
+    }
+}
+
+void AssetLoader::Finish() {
+    while (!this->IsDone()) {
+        Decoded decoded;
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            m_decodedSignal.wait(guard, [this] { return !m_decoded.empty(); });
+            decoded = std::move(m_decoded.front());
+            m_decoded.pop_front();
+        }
+        this->upload(decoded);
+    }
+}
 
 
 string GameSceneKindToString(GameSceneKind t){
@@ -84,47 +186,43 @@ string GameSceneKindToString(GameSceneKind t){
         case GameSceneKind::GAME_INTRO: return "GAME_INTRO";
         case GameSceneKind::AQUARIUM_GAME: return "AQUARIUM_GAME";
         case GameSceneKind::GAME_OVER: return "GAME_OVER";
+        case GameSceneKind::COUNT: break;
     };
     return "IDK";
 };
 
-std::shared_ptr<GameScene> GameSceneManager::GetScene(string name){
-    if(!this->HasScenes()){return nullptr;}
-    for(std::shared_ptr<GameScene> scene : this->m_scenes){
-        if(scene->GetName() == name){
-            return scene;
-        }
-    }
-    return nullptr;
-}
-
-void GameSceneManager::Transition(string name){
-    if(!this->HasScenes()){return;} // no need to do anything if nothing inside
-    std::shared_ptr<GameScene> newScene = this->GetScene(name);
+void GameSceneManager::Transition(GameSceneKind kind){
+    const std::shared_ptr<GameScene>& newScene = this->GetScene(kind);
     if(newScene == nullptr){return;} // i dont have the scene so time to leave
-    if(newScene->GetName() == this->m_active_scene->GetName()){return;} // another do nothing since active scene is already pulled
+    if(kind == this->m_activeKind){return;} // another do nothing since active scene is already pulled
+    this->Preload(kind); // normally done already, while the last scene was up
+    if(this->m_active_scene != nullptr){
+        this->m_active_scene->Exit();
+    }
     this->m_active_scene = newScene; // now we keep it since this is a valid transition
-    return;
+    this->m_activeKind = kind;
+    newScene->Enter();
+    this->Preload(newScene->GetNextKind());
 }
 
 void GameSceneManager::AddScene(std::shared_ptr<GameScene> newScene){
-    if(this->GetScene(newScene->GetName()) != nullptr){
+    GameSceneKind kind = newScene->GetKind();
+    if(this->GetScene(kind) != nullptr){
         return; // this scene already exist and shouldnt be added again
     }
-    this->m_scenes.push_back(newScene);
-    if(m_active_scene == nullptr){
-        this->m_active_scene = newScene; // need to place in active scene as its the only one in existance right now
+    this->m_scenes[(size_t)kind] = std::move(newScene);
+    if(this->m_active_scene == nullptr){
+        this->Transition(kind); // need to place in active scene as its the only one in existance right now
+    } else if(this->m_active_scene->GetNextKind() == kind){
+        this->Preload(kind); // added after the scene that leads to it was entered
     }
-    return;
 }
 
-std::shared_ptr<GameScene> GameSceneManager::GetActiveScene(){
-    return this->m_active_scene;
-}
-
-string GameSceneManager::GetActiveSceneName(){
-    if(this->m_active_scene == nullptr){return "";} // something to handle missing activate scenes
-    return this->m_active_scene->GetName();
+void GameSceneManager::Preload(GameSceneKind kind){
+    if(kind == GameSceneKind::COUNT || this->m_scenes[(size_t)kind] == nullptr){return;}
+    if(this->m_preloaded[(size_t)kind]){return;}
+    this->m_preloaded[(size_t)kind] = true;
+    this->m_scenes[(size_t)kind]->Preload();
 }
 
 void GameSceneManager::UpdateActiveScene(){
@@ -147,6 +245,10 @@ void GameIntroScene::Draw(){
     this->m_banner->draw(0,0);
 }
 
+void GameOverScene::Preload(){
+    this->m_banner = this->m_loader.LoadSprite(this->m_bannerPath, ofGetWindowWidth(), ofGetWindowHeight());
+}
+
 void GameOverScene::Update(){
 
 }
@@ -3,227 +3,212 @@
 #include <utility>
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include "ofMain.h"
+#include "sim/SimCore.h"
 
+// ofLogVerbose for per-frame code (draw paths): same compile-time floor and
+// lazy arguments as the SIM_LOG macros, gated on ofGetLogLevel at runtime.
+#define APP_LOG_VERBOSE() SIM_LOG_IF(SIM_LOG_COMPILED(SimLogLevel::Verbose) && ofGetLogLevel() <= OF_LOG_VERBOSE) ofLogVerbose()
 
-class AwaitFrames {
-public:
-	AwaitFrames(int frames) : m_frames(frames), m_counter(0) {}
-	bool tick() {
-		if (m_counter < m_frames) {
-			++m_counter;
-			return false;
-		}
-		m_counter = 0; // Reset counter after reaching the target
-		return true;
-	}
-private:
-	int m_frames;
-	int m_counter;
-};
 
+// Loaded once and never modified afterwards, creatures share it through a SpriteHandle.
+// Sprites start out empty at their final size and get their pixels when the
+// AssetLoader uploads them, until then they draw nothing.
 class GameSprite {
 public:
-    GameSprite(const std::string& imagePath, int width, int height) {
-        if (!m_image.load(imagePath)) {
-            std::cerr << "Failed to load image: " << imagePath << std::endl;
-        }
-        m_image.resize(width, height);
-        m_flippedImage = m_image;
-        m_flippedImage.mirror(false, true); // Mirror horizontally
+    GameSprite(int width, int height) : m_width(width), m_height(height) {}
+    GameSprite(const GameSprite&) = delete; // copying would duplicate the pixels and textures
+    GameSprite& operator=(const GameSprite&) = delete;
+
+    // main thread only, creates the texture. pixels are already at the sprite's size.
+    void upload(const ofPixels& pixels) {
+        m_image.setFromPixels(pixels);
+        m_loaded = true;
     }
+    bool isLoaded() const { return m_loaded; }
 
-    void draw(float x, float y) const {
-        if (m_flipped) {
-            m_flippedImage.draw(x, y);
+    void draw(float x, float y, bool flipped = false) const {
+        if (!m_loaded) return;
+        if (flipped) {
+            // a negative width mirrors horizontally over the same area
+            m_image.draw(x + m_width, y, -m_width, m_height);
         } else {
             m_image.draw(x, y);
         }
     }
 
-    void setFlipped(bool flipped) { m_flipped = flipped; }
+    float getWidth() const { return m_width; }
+    float getHeight() const { return m_height; }
+    const ofPixels& getPixels() const { return m_image.getPixels(); }
 
 private:
     ofImage m_image;
-    ofImage m_flippedImage;
-    bool m_flipped = false;
+    float m_width;
+    float m_height;
+    bool m_loaded = false;
 };
 
 
-enum class AquariumCreatureType:int;
-class PlayerCreature;
-class Creature {
-protected:
-    Creature(float x, float y, int speed, float collisionRadius, int value,
-             std::shared_ptr<GameSprite> sprite)
-    : m_x(x)
-    , m_y(y)
-    , m_dx(0)
-    , m_dy(0)
-    , m_speed(speed)
-    , m_width(0)
-    , m_height(0)
-    , m_collisionRadius(collisionRadius)
-    , m_value(value)
-    , m_sprite(std::move(sprite)) {}
-
-    float m_x = 0.0f;
-    float m_y = 0.0f;
-    float m_dx = 0.0f;
-    float m_dy = 0.0f;
-    int m_speed = 0;
-    float m_width = 0.0f;
-    float m_height = 0.0f;
-    float m_collisionRadius = 0.0f;
-    int m_value = 0;
-    int m_powerRequired=1;
-    std::shared_ptr<GameSprite> m_sprite;
-     AquariumCreatureType m_type;
-public:
-    virtual ~Creature() = default;
-    virtual void move() = 0;
-    virtual void move(std::shared_ptr<PlayerCreature> player) {
-    move();
-}
-    virtual void draw() const = 0;
-
-    virtual bool isExpired() const {return false;}
-    virtual float getCollisionRadius() const { return m_collisionRadius; }
-    virtual void setCollisionRadius(float radius) { m_collisionRadius = radius; }
-
-    float getX() const { return m_x; }
-    float getY() const { return m_y; }
-    int getSpeed() const { return m_speed; }
-    void setSpeed(int speed) { m_speed = speed; }
-    void setFlipped(bool flipped) {
-        if (m_sprite) {
-            m_sprite->setFlipped(flipped);
-        }
-    }
-    void setSprite(std::shared_ptr<GameSprite> sprite) { m_sprite = std::move(sprite); }
-    int getValue() const { return m_value; }
-
-    void setBounds(int w, int h);
-    void normalize();
-    void bounce();
-    int getPowerRequired() const{return m_powerRequired;}
-    void setPowerRequired(int p) {m_powerRequired =p;}
-    AquariumCreatureType getType() const {return m_type;}
+// Where a sprite ended up inside a SpriteAtlas, uv0 is the top left corner
+struct SpriteAtlasRegion {
+    ofDefaultTexCoordType uv0;
+    ofDefaultTexCoordType uv1;
+    float width = 0.0f;
+    float height = 0.0f;
 };
 
-// GameEvents
-enum class GameEventType {
-    NONE,
-    COLLISION,
-    CREATURE_ADDED,
-    CREATURE_REMOVED,
-    GAME_OVER,
-    GAME_EXIT,
-    NEW_LEVEL,
-};
+// Packs several sprites into one texture so they can all be drawn with a
+// single bind. Sprites that weren't packed just have no region.
+class SpriteAtlas {
+public:
+    void Build(const std::vector<SpriteHandle>& sprites);
+    const SpriteAtlasRegion* GetRegion(const GameSprite* sprite) const;
+    bool IsBuilt() const { return m_texture.isAllocated(); }
+    void bind() const { m_texture.bind(); }
+    void unbind() const { m_texture.unbind(); }
 
-class GameEvent {
-    public:
-    GameEventType type;
-    std::shared_ptr<Creature> creatureA;
-    std::shared_ptr<Creature> creatureB; // For collision events
-    GameEvent() : type(GameEventType::NONE), creatureA(nullptr), creatureB(nullptr) {}
-    GameEvent(GameEventType t, std::shared_ptr<Creature> a , std::shared_ptr<Creature> b){
-        type = t;
-        creatureA = a;
-        creatureB = b;
-    }
-    
-    // Additional methods can be added here
-    bool isCollisionEvent() const { return type == GameEventType::COLLISION; }
-    bool isCreatureAddedEvent() const { return type == GameEventType::CREATURE_ADDED; }
-    bool isCreatureRemovedEvent() const { return type == GameEventType::CREATURE_REMOVED; }
-    bool isGameOver() const { return type == GameEventType::GAME_OVER; }
-    bool isGameExit() const { return type == GameEventType::GAME_EXIT; }
-    bool isNoneEvent() const { return type == GameEventType::NONE; }
-    
-    // i want a printable representation of the event, with the creature descriptions if available
-    void print() const;
+private:
+    ofTexture m_texture;
+    std::vector<std::pair<const GameSprite*, SpriteAtlasRegion>> m_regions;
 };
 
 
-
-
-bool checkCollision(std::shared_ptr<Creature> a, std::shared_ptr<Creature> b);
-
-
-class GameLevel {
+// Loads images off the main thread. Worker threads decode and resize, the main
+// thread uploads the finished ones to textures in small batches from Update so
+// no single frame pays for all of them. Callers get the sprite straight away
+// and it fills in once uploaded.
+class AssetLoader {
 public:
-    GameLevel(int levelNumber) : m_levelNumber(levelNumber) {}
-    virtual ~GameLevel() = default;
-    int getLevelNumber() const { return m_levelNumber; }
-    virtual bool isCompleted() = 0;
-
-protected:
-    int m_levelNumber;
-    
-};
+    // 0 workers is one per hardware thread beyond the main one
+    explicit AssetLoader(int workers = 0);
+    ~AssetLoader();
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // queues an image from bin/data, resized to width x height
+    SpriteHandle LoadSprite(const std::string& path, int width, int height);
+    // runs on the main thread once everything queued so far is uploaded
+    void WhenLoaded(std::function<void()> callback);
+
+    // main thread, once a frame: uploads at most maxUploads decoded images
+    void Update(int maxUploads);
+    // main thread, waits for and uploads everything still queued
+    void Finish();
+    bool IsDone() const { return m_uploaded == m_requested; }
 
+private:
+    struct Request {
+        std::string path;
+        int width;
+        int height;
+        std::shared_ptr<GameSprite> sprite;
+    };
+    struct Decoded {
+        std::shared_ptr<GameSprite> sprite;
+        ofPixels pixels;
+        std::string path;
+        bool ok;
+    };
+
+    void workerLoop();
+    void upload(Decoded& decoded);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_lock; // guards the two queues and m_stop
+    std::condition_variable m_wake; // a request came in, or shutting down
+    std::condition_variable m_decodedSignal;
+    std::deque<Request> m_requests;
+    std::deque<Decoded> m_decoded;
+    bool m_stop = false;
+
+    // main thread only
+    size_t m_requested = 0;
+    size_t m_uploaded = 0;
+    std::vector<std::pair<size_t, std::function<void()>>> m_callbacks; // upload count each waits for
+};
 
+enum class GameSceneKind {
+    GAME_INTRO,
+    AQUARIUM_GAME,
+    GAME_OVER,
+    COUNT
+};
 
+string GameSceneKindToString(GameSceneKind t);
 
 class GameScene {
     public:
-        virtual string GetName() = 0;
+        virtual GameSceneKind GetKind() const = 0;
+        string GetName() const {return GameSceneKindToString(this->GetKind());}
         virtual void Update() = 0;
         virtual void Draw() = 0;
+        // lifecycle, driven by GameSceneManager. Preload runs once, while an
+        // earlier scene is still up, so entering has nothing slow left to do.
+        virtual void Preload() {}
+        virtual void Enter() {}
+        virtual void Exit() {}
+        // the scene this one leads to, preloaded as soon as this one is entered
+        virtual GameSceneKind GetNextKind() const {return GameSceneKind::COUNT;}
         virtual ~GameScene() = default;
 
 };
 
-enum class GameSceneKind {
-    GAME_INTRO,
-    AQUARIUM_GAME,
-    GAME_OVER
-};
-
-string GameSceneKindToString(GameSceneKind t);
-
 class GameIntroScene : public GameScene {
     public:
-        GameIntroScene(string name, std::shared_ptr<GameSprite> banner)
-        : m_name(name), m_banner(std::move(banner)){};
-        string GetName() override {return this->m_name;}
+        explicit GameIntroScene(SpriteHandle banner)
+        : m_banner(std::move(banner)){};
+        GameSceneKind GetKind() const override {return GameSceneKind::GAME_INTRO;}
+        GameSceneKind GetNextKind() const override {return GameSceneKind::AQUARIUM_GAME;}
         void Update() override;
         void Draw() override;
     private:
-        string m_name;
-        std::shared_ptr<GameSprite> m_banner;
+        SpriteHandle m_banner;
 };
 
+// the banner is only queued on Preload, while the game is being played
 class GameOverScene : public GameScene {
     public:
-        GameOverScene(string name, std::shared_ptr<GameSprite> banner)
-        : m_name(name), m_banner(std::move(banner)){};
-        string GetName() override {return this->m_name;}
+        GameOverScene(AssetLoader& loader, string bannerPath)
+        : m_loader(loader), m_bannerPath(std::move(bannerPath)){};
+        GameSceneKind GetKind() const override {return GameSceneKind::GAME_OVER;}
+        void Preload() override;
         void Update() override;
         void Draw() override;
     private:
-        string m_name;
-        std::shared_ptr<GameSprite> m_banner;
+        AssetLoader& m_loader;
+        string m_bannerPath;
+        SpriteHandle m_banner;
 };
 
 
+// One slot per GameSceneKind, so lookups and "is this scene up" checks are an
+// index and a compare. Transition exits the old scene, enters the new one and
+// preloads whatever comes after it.
 class GameSceneManager {
     public:
-        void Transition(string name);
+        void Transition(GameSceneKind kind);
+        // the first scene added becomes the active one
         void AddScene(std::shared_ptr<GameScene> newScene);
-        bool HasScenes(){return m_scenes.size() > 0; }
-        std::shared_ptr<GameScene> GetScene(string name);
-        std::shared_ptr<GameScene> GetActiveScene();
+        void Preload(GameSceneKind kind); // only the first call does anything
+        bool HasScenes() const {return m_active_scene != nullptr; }
+        const std::shared_ptr<GameScene>& GetScene(GameSceneKind kind) const {return m_scenes[(size_t)kind];}
+        const std::shared_ptr<GameScene>& GetActiveScene() const {return m_active_scene;}
+        bool IsActive(GameSceneKind kind) const {return m_activeKind == kind;}
         
         // support the functionality
-        string GetActiveSceneName();
         void UpdateActiveScene();
         void DrawActiveScene();
 
     private:
-        std::vector<std::shared_ptr<GameScene>> m_scenes;
+        std::array<std::shared_ptr<GameScene>, (size_t)GameSceneKind::COUNT> m_scenes;
+        std::array<bool, (size_t)GameSceneKind::COUNT> m_preloaded{};
         std::shared_ptr<GameScene> m_active_scene;
+        GameSceneKind m_activeKind = GameSceneKind::COUNT; // COUNT while there is none
 
 };
\ No newline at end of file
@@ -1,14 +1,48 @@
 #include "ofApp.h"
+#include <random>
 
 //--------------------------------------------------------------
 void ofApp::setup(){
 
+    // the simulation logs through its own stream, send it to ofLog like the rest of the app
+    SetSimLogSink([](SimLogLevel level, const std::string& message){
+        switch(level){
+            case SimLogLevel::Verbose: ofLogVerbose() << message; break;
+            case SimLogLevel::Notice: ofLogNotice() << message; break;
+            case SimLogLevel::Warning: ofLogWarning() << message; break;
+            default: ofLogError() << message; break;
+        }
+    });
+
+    // before anything asks for the pool
+    SetSimWorkerCount(SIM_WORKERS);
+
+    // a replay brings its own seed and tick rate
+    replaying = !REPLAY_FILE.empty() && inputLog.Load(ofToDataPath(REPLAY_FILE));
+    if (!REPLAY_FILE.empty() && !replaying) {
+        ofLogError() << "can't read input log " << REPLAY_FILE << ", playing normally";
+    }
+    if (replaying) {
+        SetSimSeed(inputLog.seed);
+        SIM_TICK_RATE = inputLog.tickRate;
+    } else {
+        // logged so a run can be replayed by putting its seed in SIM_SEED
+        SetSimSeed(SIM_SEED != 0 ? SIM_SEED : ((uint64_t)std::random_device()() << 32 | std::random_device()()));
+    }
+    ofLogNotice() << "simulation seed: " << GetSimSeed();
+
+    // the world can be bigger than the window, a replay runs in the world it was recorded in
+    worldWidth = replaying ? inputLog.width : (WORLD_WIDTH > 0 ? WORLD_WIDTH : ofGetWindowWidth());
+    worldHeight = replaying ? inputLog.height : (WORLD_HEIGHT > 0 ? WORLD_HEIGHT : ofGetWindowHeight());
+
     ofSetFrameRate(60);
     ofSetBackgroundColor(ofColor::blue);
-    backgroundImage.load("background.png");
-    backgroundImage.resize(ofGetWindowWidth(), ofGetWindowHeight());
+    // images decode on the loader's threads and show up over the first frames,
+    // the ones on screen first are queued first
+    backgroundImage = assetLoader.LoadSprite("background.png", ofGetWindowWidth(), ofGetWindowHeight());
+    SpriteHandle titleImage = assetLoader.LoadSprite("title.png", ofGetWindowWidth(), ofGetWindowHeight());
 
-    music.load("ZeldaWindWaker_Loop.wav");
+    music.load("ZeldaWindWaker_Loop.wav", true); // streamed, not decoded up front
     music.setMultiPlay(false);
     music.setLoop(true);
     music.play();
@@ -21,36 +55,24 @@ void ofApp::setup(){
 
 
     // first we make the intro scene 
-    gameManager->AddScene(std::make_shared<GameIntroScene>(
-        GameSceneKindToString(GameSceneKind::GAME_INTRO),
-        std::make_shared<GameSprite>("title.png", ofGetWindowWidth(), ofGetWindowHeight())
-    ));
+    gameManager->AddScene(std::make_shared<GameIntroScene>(titleImage));
 
     //AquariumSpriteManager
-    spriteManager = std::make_shared<AquariumSpriteManager>();
+    spriteManager = std::make_shared<AquariumSpriteManager>(assetLoader);
+
+    // levels and player speed come from settings.xml, compiled into settings.bin on first run
+    std::shared_ptr<const LevelTable> levels = LoadLevelTable(ofToDataPath("settings.xml"), ofToDataPath("settings.bin"));
 
     // Lets setup the aquarium
-    myAquarium = std::make_shared<Aquarium>(ofGetWindowWidth(), ofGetWindowHeight(), spriteManager);
-    player = std::make_shared<PlayerCreature>(ofGetWindowWidth()/2 - 50, ofGetWindowHeight()/2 - 50, DEFAULT_SPEED, this->spriteManager->GetSprite(AquariumCreatureType::NPCreature));
+    myAquarium = std::make_shared<Aquarium>(worldWidth, worldHeight, spriteManager);
+    myAquarium->setSchoolingEnabled(SCHOOLING);
+    player = std::make_shared<PlayerCreature>(worldWidth/2 - 50, worldHeight/2 - 50, levels->playerSpeed, this->spriteManager->GetSprite(AquariumCreatureType::NPCreature));
     player->setDirection(0, 0); // Initially stationary
-    player->setBounds(ofGetWindowWidth() - 20, ofGetWindowHeight() - 20);
+    player->setBounds(worldWidth - 20, worldHeight - 20);
 
-    
-    myAquarium->addAquariumLevel(std::make_shared<Level_0>(1, 30));  
-    myAquarium->addAquariumLevel(std::make_shared<Level_1>(2, 80));   
-    myAquarium->addAquariumLevel(std::make_shared<Level_2>(3, 150)); 
-    
-    
-    if(myAquarium->getLevelCount()>0) {
-        myAquarium->getLevel(0)->initialize();
-        myAquarium->getLevel(0)->spawnWave(myAquarium);
 
-    }
-    
-    
-    myAquarium->Repopulate(player); 
+    InitializeAquariumLevels(myAquarium, player, levels);
 
-    
     ofLogNotice() << "Sistema de niveles progresivos inicializado!";
     ofLogNotice() << "Nivel 1: " << myAquarium->getLevel(0)->getLevelDescription();
 
@@ -58,9 +80,20 @@ void ofApp::setup(){
 
 
     // now that we are mostly set, lets pass the player and the aquarium downstream
-    gameManager->AddScene(std::make_shared<AquariumGameScene>(
-        std::move(player), std::move(myAquarium), GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)
-    )); // player and aquarium are owned by the scene moving forward
+    auto aquariumScene = std::make_shared<AquariumGameScene>(
+        std::move(player), std::move(myAquarium), spriteManager
+    ); // player and aquarium are owned by the scene moving forward
+    aquariumScene->SetTickRate(SIM_TICK_RATE);
+    gameManager->AddScene(aquariumScene);
+    if (replaying) {
+        aquariumScene->StartReplay(&inputLog);
+    } else if (RECORD_INPUT) {
+        inputLog.seed = GetSimSeed();
+        inputLog.tickRate = SIM_TICK_RATE;
+        inputLog.width = worldWidth;
+        inputLog.height = worldHeight;
+        aquariumScene->SetRecorder(&inputLog);
+    }
 
     // Load font for game over message
     gameOverTitle.load("Verdana.ttf", 12, true, true);
@@ -68,25 +101,61 @@ void ofApp::setup(){
     gameOverTitle.setLetterSpacing(1.035);
 
 
-    gameManager->AddScene(std::make_shared<GameOverScene>(
-        GameSceneKindToString(GameSceneKind::GAME_OVER),
-        std::make_shared<GameSprite>("game-over.png", ofGetWindowWidth(), ofGetWindowHeight())
-    ));
+    // its banner is queued once the game starts
+    gameManager->AddScene(std::make_shared<GameOverScene>(assetLoader, "game-over.png"));
 
     ofSetLogLevel(OF_LOG_NOTICE); // Set default log level
+    SetSimLogLevel(SimLogLevel::Notice);
+
+    // straight into the game, unthrottled, with the profiler up
+    if (replaying) {
+        assetLoader.Finish(); // frame times shouldn't include loading
+        ofSetFrameRate(0);
+        ofSetVerticalSync(false);
+        aquariumScene->GetProfiler().SetEnabled(true);
+        gameManager->Transition(GameSceneKind::AQUARIUM_GAME);
+        replayStart = ofGetElapsedTimef();
+    }
+}
+
+void ofApp::saveInputLog(){
+    if (!RECORD_INPUT || replaying) return;
+    auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKind::AQUARIUM_GAME));
+    inputLog.tickCount = gameScene->GetTickCount();
+    if (inputLog.Save(ofToDataPath("session.aqin"))) {
+        ofLogNotice() << "input log saved: " << inputLog.events.size() << " key events over " << inputLog.tickCount << " ticks";
+    } else {
+        ofLogError() << "can't write the input log";
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
-    
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_OVER)){
+    if (backgroundResizedAt >= 0.0f && ofGetElapsedTimef() - backgroundResizedAt > 0.25f) {
+        // the old background stays up until the resized one is ready
+        SpriteHandle resized = assetLoader.LoadSprite("background.png", backgroundWidth, backgroundHeight);
+        assetLoader.WhenLoaded([this, resized](){ backgroundImage = resized; });
+        backgroundResizedAt = -1.0f;
+    }
+    assetLoader.Update(UPLOADS_PER_FRAME);
+
+    if(gameManager->IsActive(GameSceneKind::GAME_OVER)){
         return; // Stop updating if game is over or exiting
     }
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
         auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
         if(gameScene->GetLastEvent() != nullptr && gameScene->GetLastEvent()->isGameOver()){
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::GAME_OVER));
+            saveInputLog();
+            gameManager->Transition(GameSceneKind::GAME_OVER);
+            return;
+        }
+        if(replaying && gameScene->IsReplayFinished()){
+            double seconds = ofGetElapsedTimef() - replayStart;
+            const FrameProfiler& profiler = gameScene->GetProfiler();
+            ofLogNotice() << "replay finished: " << gameScene->GetTickCount() << " ticks in " << seconds << " s, frame p50 "
+                          << profiler.GetFramePercentileMs(0.5) << " ms p99 " << profiler.GetFramePercentileMs(0.99) << " ms";
+            ofExit();
             return;
         }
         
@@ -100,13 +169,16 @@ void ofApp::update(){
 
 //--------------------------------------------------------------
 void ofApp::draw(){
-    backgroundImage.draw(0, 0);
+    backgroundImage->draw(0, 0);
     gameManager->DrawActiveScene();
 }
 
 //--------------------------------------------------------------
 void ofApp::exit(){
-    
+    // quitting mid game still keeps the session
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
+        saveInputLog();
+    }
 }
 
 //--------------------------------------------------------------
@@ -115,39 +187,48 @@ void ofApp::keyPressed(int key){
         ofLogNotice() << "Game has ended. Press ESC to exit." << std::endl;
         return; // Ignore other keys after game over
     }
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
         auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
+        ProfileScope inputScope(&gameScene->GetProfiler(), ProfilePhase::Input);
         switch(key){
+            case 'p':
+                gameScene->ToggleProfiler(); // frame timings overlay
+                break;
+            case OF_KEY_F5:
+                if (gameScene->SaveSnapshot(ofToDataPath(SNAPSHOT_FILE))) {
+                    ofLogNotice() << "saved " << SNAPSHOT_FILE;
+                }
+                break;
+            case OF_KEY_F9:
+                if (gameScene->LoadSnapshot(ofToDataPath(SNAPSHOT_FILE))) {
+                    ofLogNotice() << "loaded " << SNAPSHOT_FILE;
+                }
+                break;
             case OF_KEY_UP:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, -1);
+                gameScene->PressKey(PlayerKey::Up, true);
                 break;
-                case OF_KEY_DOWN:
-                gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 1);
+            case OF_KEY_DOWN:
+                gameScene->PressKey(PlayerKey::Down, true);
                 break;
             case OF_KEY_LEFT:
-                gameScene->GetPlayer()->setDirection(-1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(true);
+                gameScene->PressKey(PlayerKey::Left, true);
                 break;
-                case OF_KEY_RIGHT:
-                gameScene->GetPlayer()->setDirection(1, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-                gameScene->GetPlayer()->setFlipped(false);
+            case OF_KEY_RIGHT:
+                gameScene->PressKey(PlayerKey::Right, true);
                 break;
             default:
                 break;
         }
-    
-        
-    
-        gameScene->GetPlayer()->move();
         return;
 
     }
 
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::GAME_INTRO)){
+    if(gameManager->IsActive(GameSceneKind::GAME_INTRO)){
         switch (key)
         {
         case OF_KEY_SPACE:
-            gameManager->Transition(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME));
+            assetLoader.Finish(); // usually long done, gameplay never waits on the disk
+            gameManager->Transition(GameSceneKind::AQUARIUM_GAME);
             break;
         
         default:
@@ -162,20 +243,16 @@ void ofApp::keyPressed(int key){
 
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key){
-    if(gameManager->GetActiveSceneName() == GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)){
+    if(gameManager->IsActive(GameSceneKind::AQUARIUM_GAME)){
         auto gameScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetActiveScene());
-    if( key == OF_KEY_UP || key == OF_KEY_DOWN){
-        gameScene->GetPlayer()->setDirection(gameScene->GetPlayer()->isXDirectionActive()?gameScene->GetPlayer()->getDx():0, 0);
-        gameScene->GetPlayer()->move();
-        return;
-    }
-    
-    if(key == OF_KEY_LEFT || key == OF_KEY_RIGHT){
-        gameScene->GetPlayer()->setDirection(0, gameScene->GetPlayer()->isYDirectionActive()?gameScene->GetPlayer()->getDy():0);
-        gameScene->GetPlayer()->move();
-        return;
-    }
-
+        ProfileScope inputScope(&gameScene->GetProfiler(), ProfilePhase::Input);
+        switch(key){
+            case OF_KEY_UP: gameScene->PressKey(PlayerKey::Up, false); break;
+            case OF_KEY_DOWN: gameScene->PressKey(PlayerKey::Down, false); break;
+            case OF_KEY_LEFT: gameScene->PressKey(PlayerKey::Left, false); break;
+            case OF_KEY_RIGHT: gameScene->PressKey(PlayerKey::Right, false); break;
+            default: break;
+        }
     }
 }
 
@@ -216,10 +293,18 @@ void ofApp::mouseExited(int x, int y){
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
-    backgroundImage.resize(w, h);
-    auto aquariumScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKindToString(GameSceneKind::AQUARIUM_GAME)));
-    aquariumScene->GetAquarium()->setBounds(w,h);
-    aquariumScene->GetPlayer()->setBounds(w - 20, h - 20);
+    // reloaded from update once the size settles
+    backgroundWidth = w;
+    backgroundHeight = h;
+    backgroundResizedAt = ofGetElapsedTimef();
+    // a world that follows the window grows and shrinks with it, a fixed one
+    // just shows more or less of itself
+    if (replaying) return;
+    worldWidth = WORLD_WIDTH > 0 ? WORLD_WIDTH : w;
+    worldHeight = WORLD_HEIGHT > 0 ? WORLD_HEIGHT : h;
+    auto aquariumScene = std::static_pointer_cast<AquariumGameScene>(gameManager->GetScene(GameSceneKind::AQUARIUM_GAME));
+    aquariumScene->GetAquarium()->setBounds(worldWidth, worldHeight);
+    aquariumScene->GetPlayer()->setBounds(worldWidth - 20, worldHeight - 20);
 
 }
 
@@ -27,7 +27,23 @@ class ofApp : public ofBaseApp{
 	
 		
 		char moveDirection;
-		int DEFAULT_SPEED = 5;
+		float SIM_TICK_RATE = 60.0f; // simulation ticks per second, drawing runs at whatever the frame rate is
+		uint64_t SIM_SEED = 0; // seed for the simulation's random numbers, 0 picks a new one every run
+		int SIM_WORKERS = 0; // threads the simulation splits a tick across, 0 uses every core and 1 keeps it on the main thread
+		bool RECORD_INPUT = false; // writes the session's seed and keys to bin/data/session.aqin when it ends
+		std::string REPLAY_FILE = ""; // input log in bin/data to play back as fast as frames draw, empty plays normally
+		std::string SNAPSHOT_FILE = "quicksave.aqss"; // save state in bin/data, F5 writes it and F9 loads it
+		int WORLD_WIDTH = 0; // aquarium size in pixels, the camera follows the player around it.
+		int WORLD_HEIGHT = 0; // 0 makes it the window size on that axis
+		bool SCHOOLING = false; // base fish swim in schools (boids) instead of straight lines
+		int UPLOADS_PER_FRAME = 2; // loaded images turned into textures each frame while assets stream in
+
+		void saveInputLog();
+		InputLog inputLog; // being recorded, or played back
+		bool replaying = false;
+		int worldWidth = 0; // the aquarium's actual size, WORLD_WIDTH/HEIGHT or the window's
+		int worldHeight = 0;
+		double replayStart = 0.0;
 
 
 		AwaitFrames acuariumUpdate{5};
@@ -36,7 +52,13 @@ class ofApp : public ofBaseApp{
 		GameEvent lastEvent;
 
 
-		ofImage backgroundImage;
+		AssetLoader assetLoader; // declared first so it outlives the sprite manager it calls back into
+		SpriteHandle backgroundImage;
+		// a drag-resize sends dozens of sizes, the background is only
+		// reloaded once the window has kept one for a moment
+		float backgroundResizedAt = -1.0f; // elapsed time of the last resize, -1 when nothing is pending
+		int backgroundWidth = 0;
+		int backgroundHeight = 0;
 
 		std::unique_ptr<GameSceneManager> gameManager;
 		std::shared_ptr<AquariumSpriteManager>spriteManager;
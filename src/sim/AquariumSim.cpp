@@ -0,0 +1,877 @@
+#include "AquariumSim.h"
+#include <cstdlib>
+
+
+std::string AquariumCreatureTypeToString(AquariumCreatureType t){
+    switch(t){
+        case AquariumCreatureType::BiggerFish:
+            return "BiggerFish";
+        case AquariumCreatureType::NPCreature:
+            return "BaseFish";
+        default:
+            return "UknownFish";
+    }
+}
+
+// PlayerCreature Implementation
+PlayerCreature::PlayerCreature(float x, float y, int speed, SpriteHandle sprite)
+: Creature(x, y, speed, 10.0f, 1, sprite){
+    m_type = AquariumCreatureType::Player;
+}
+
+
+void PlayerCreature::setDirection(float dx, float dy) {
+    velX() = dx;
+    velY() = dy;
+    normalize();
+}
+
+void PlayerCreature::move() {
+    posX() += velX() * m_speed * m_stepFrames;
+    posY() += velY() * m_speed * m_stepFrames;
+    this->bounce();
+}
+
+void PlayerCreature::reduceDamageDebounce() {
+    if (m_damage_debounce > 0) {
+        m_damage_debounce -= m_stepFrames;
+    }
+}
+
+void PlayerCreature::update(float frames) {
+    m_stepFrames = frames;
+    this->reduceDamageDebounce();
+    this->move();
+    this->updateSizeBoost();
+    this->updateSpeedFruit();
+    m_stepFrames = 1.0f; // key presses still nudge by one frame
+}
+
+
+void PlayerCreature::changeSpeed(int speed) {
+    m_speed = speed;
+}
+
+void PlayerCreature::loseLife(int debounce) {
+    if (m_damage_debounce <= 0) {
+        if (m_lives > 0) this->m_lives -= 1;
+        m_damage_debounce = debounce; // Set debounce frames
+        SIM_LOG_NOTICE() << "Player lost a life! Lives remaining: " << m_lives << std::endl;
+    }
+    // If in debounce period, do nothing
+    if (m_damage_debounce > 0) {
+        SIM_LOG_VERBOSE() << "Player is in damage debounce period. Frames left: " << m_damage_debounce << std::endl;
+    }
+}
+void PlayerCreature::activateSizeBoost(){
+if(!m_sizeActive){
+    m_sizeActive=true;
+    m_sizeTimer=m_sizeDuration;
+    m_power +=1;
+    m_sizeScale=1.5f;
+     setCollisionRadius(m_defaultCollisionRad * m_sizeScale);
+    SIM_LOG_NOTICE() << "Grow-Grow Devil Fruit Activated! Power: " << m_power;
+    }
+}
+void PlayerCreature::updateSizeBoost(){
+    if(m_sizeActive){
+        m_sizeTimer -= m_stepFrames;
+        if(m_sizeTimer<=0){
+            m_sizeActive=false;
+            m_sizeScale=1.0f;
+            m_power-=1;
+            SIM_LOG_NOTICE() << "Size Boost Ended. Power: " << m_power;
+        }
+    }
+}
+void PlayerCreature::activateSpeedFruit(){
+    if(!m_speedFruitActive){
+         m_speedFruitActive = true;
+        m_speedFruitTime = m_speedFruitDuration;
+        m_speedNormal = m_speed;
+        m_speed *= 1.5f;
+        SIM_LOG_NOTICE() << " Light-Speed Fruit Activated! New Speed: " << m_speed;
+    }
+}
+void PlayerCreature::updateSpeedFruit() {
+    if (m_speedFruitActive) {
+        m_speedFruitTime -= m_stepFrames;
+        if (m_speedFruitTime <= 0) {
+            m_speedFruitActive = false;
+            m_speed = m_speedNormal; // Restaura velocidad
+            SIM_LOG_NOTICE() << "Speed Boost Ended. Speed: " << m_speed;
+        }
+    }
+}
+
+// NPCreature Implementation
+NPCreature::NPCreature(float x, float y, int speed, SpriteHandle sprite)
+: Creature(x, y, speed, 30, 1, sprite) {
+    Pcg32& random = SimRandom(SimRandomStream::Creature);
+    velX() = random.range(-1, 1);
+    velY() = random.range(-1, 1);
+    normalize();
+
+    m_type = AquariumCreatureType::NPCreature;
+    m_value=2;
+    m_powerRequired=1;
+}
+
+void NPCreature::move() {
+    // Simple AI movement logic (random direction)
+    posX() += velX() * m_speed;
+    posY() += velY() * m_speed;
+    setFlipped(velX() < 0);
+    bounce();
+}
+
+BiggerFish::BiggerFish(float x, float y, int speed, SpriteHandle sprite)
+: NPCreature(x, y, speed, sprite) {
+    Pcg32& random = SimRandom(SimRandomStream::Creature);
+    velX() = random.range(-1, 1);
+    velY() = random.range(-1, 1);
+    normalize();
+
+    setCollisionRadius(60); // Bigger fish have a larger collision radius
+    m_value = 5; // Bigger fish have a higher value
+    m_powerRequired=6;
+    m_type = AquariumCreatureType::BiggerFish;
+}
+
+void BiggerFish::move() {
+    // Bigger fish might move slower or have different logic
+    posX() += velX() * (m_speed * 0.5); // Moves at half speed
+    posY() += velY() * (m_speed * 0.5);
+    setFlipped(velX() < 0);
+
+    bounce();
+}
+
+GyaradosFish::GyaradosFish(float x, float y, int speed, SpriteHandle sprite)
+: NPCreature(x, y, speed, sprite) {
+    m_value = 10;
+    m_type = AquariumCreatureType::GyaradosFish;
+    m_powerRequired=10;
+}
+
+void GyaradosFish::move(const std::shared_ptr<PlayerCreature>& player) {
+    float dx = player->getX() - posX();
+    float dy = player->getY() - posY();
+    float length = sqrt(dx*dx + dy*dy);
+
+    
+    if (length > 0) { 
+        setFlipped(dx < 0);
+        posX() += (dx/length) * (m_speed * 1.2f);
+        posY() += (dy/length) * (m_speed * 1.2f);
+    }
+    bounce();
+}
+
+// Aquarium Implementation
+Aquarium::Aquarium(int width, int height, std::shared_ptr<CreatureSpriteSource> spriteSource)
+    : m_width(width), m_height(height) {
+        m_sprite_source =  spriteSource;
+        m_grid.Configure(width, height, m_gridCellSize);
+    }
+
+void Aquarium::setBounds(int w, int h) {
+    m_width = w;
+    m_height = h;
+    m_grid.Configure(w, h, m_gridCellSize);
+    m_gridDirty = true;
+}
+
+void Aquarium::setGridCellSize(float cellSize) {
+    m_gridCellSize = cellSize;
+    m_grid.Configure(m_width, m_height, m_gridCellSize);
+    m_gridDirty = true;
+}
+
+
+
+CreatureHandle Aquarium::addCreature(std::shared_ptr<Creature> creature) {
+    creature->setBounds(m_width - 20, m_height - 20);
+    int slot = m_store.push();
+    creature->attachToStore(&m_store, slot);
+    CreatureHandle handle = this->acquireHandle(slot);
+    creature->setHandle(handle);
+    m_creatures.push_back(creature);
+    m_gridDirty = true;
+    return handle;
+}
+
+CreatureHandle Aquarium::acquireHandle(int slot) {
+    uint32_t index;
+    if (!m_freeHandles.empty()) {
+        index = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    } else {
+        index = m_handleSlot.size();
+        m_handleSlot.push_back(-1);
+        m_handleGeneration.push_back(0);
+    }
+    m_handleSlot[index] = slot;
+    m_store.handle[slot] = index;
+    return CreatureHandle{index, m_handleGeneration[index]};
+}
+
+// bumping the generation is what makes every outstanding copy stale
+void Aquarium::releaseHandle(uint32_t index) {
+    m_handleSlot[index] = -1;
+    ++m_handleGeneration[index];
+    m_freeHandles.push_back(index);
+}
+
+int Aquarium::getSlot(CreatureHandle handle) const {
+    if (handle.index >= m_handleSlot.size() || m_handleGeneration[handle.index] != handle.generation) {
+        return -1;
+    }
+    return m_handleSlot[handle.index];
+}
+
+std::shared_ptr<Creature> Aquarium::getCreature(CreatureHandle handle) const {
+    int slot = this->getSlot(handle);
+    return slot >= 0 ? m_creatures[slot] : nullptr;
+}
+
+CreatureHandle Aquarium::getHandleAt(int index) const {
+    if (index < 0 || size_t(index) >= m_creatures.size()) {
+        return CreatureHandle();
+    }
+    uint32_t entry = m_store.handle[index];
+    return CreatureHandle{entry, m_handleGeneration[entry]};
+}
+
+void Aquarium::addAquariumLevel(std::shared_ptr<AquariumLevel> level){
+    if(level == nullptr){return;} // guard to not add noise
+    this->m_aquariumlevels.push_back(level);
+}
+
+void Aquarium::update(std::shared_ptr<PlayerCreature> player) {
+    this->holdPositions();
+    if (m_schooling) {
+        m_school.Steer(m_store, AquariumCreatureType::NPCreature, m_width, m_height, SimJobSystem());
+    }
+    this->moveCreatures(player);
+    this->refreshGridInputs();
+    if (m_npcCollisions) {
+        this->resolveNPCCollisions();
+    } else {
+        m_npcOverlaps.clear();
+    }
+    this->rebuildGrid();
+}
+
+void Aquarium::holdPositions() {
+    m_store.prevX = m_store.x; // same size every time, no reallocation
+    m_store.prevY = m_store.y;
+}
+
+// Passive creatures all move in one pass of the SIMD kernel over the store,
+// only creatures that chase or flee go through their virtual move(player).
+// A creature's move only reads the player and writes its own slot, so the
+// store is split in chunks across the sim job system and the result is the
+// same whatever the worker count.
+void Aquarium::moveCreatures(std::shared_ptr<PlayerCreature> player) {
+    SimJobSystem().ParallelFor(m_store.size(), MOVE_CHUNK, [&](size_t begin, size_t end) {
+        IntegratePassive(m_store, begin, end, m_motionKernel);
+        for (size_t i = begin; i < end; ++i) {
+            if (m_store.motion[i] == CreatureMotion::Custom) {
+                m_creatures[i]->move(player);
+            }
+        }
+    });
+}
+
+// the grid and sweep read positions and radii straight from the store, this
+// only refreshes what they need on top of that
+void Aquarium::refreshGridInputs() {
+    size_t count = m_store.size();
+    m_isPickup.resize(count);
+    m_maxCollisionRadius = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        m_isPickup[i] = m_store.type[i] == AquariumCreatureType::PowerUp || m_store.type[i] == AquariumCreatureType::SpeedFruit;
+        m_maxCollisionRadius = std::max(m_maxCollisionRadius, m_store.radius[i]);
+    }
+}
+
+void Aquarium::resolveNPCCollisions() {
+    m_sweep.FindOverlaps(m_store.size(), m_store.x.data(), m_store.y.data(), m_store.radius.data(),
+                         m_isPickup.data(), m_npcOverlaps);
+    if (!m_npcSeparation || m_npcOverlaps.empty()) return;
+
+    SweepAndPrune::Separate(m_npcOverlaps, m_store.x.data(), m_store.y.data(), m_store.radius.data());
+    for (size_t i = 0; i < m_store.size(); ++i) {
+        // keep pushed fish inside the same walls bounce() uses
+        float r = m_store.radius[i];
+        m_store.x[i] = std::min(std::max(m_store.x[i], r), std::max(r, m_store.boundW[i] - r));
+        m_store.y[i] = std::min(std::max(m_store.y[i], r), std::max(r, m_store.boundH[i] - r));
+    }
+}
+
+// expects refreshGridInputs() to be current
+void Aquarium::rebuildGrid() {
+    m_grid.Rebuild(m_store.size(), m_store.x.data(), m_store.y.data());
+    m_gridDirty = false;
+}
+
+void Aquarium::queryRadius(float x, float y, float r, std::vector<int>& out) {
+    if (m_gridDirty) { this->refreshGridInputs(); this->rebuildGrid(); }
+    m_grid.QueryRadius(x, y, r, out);
+}
+
+std::vector<int> Aquarium::queryRadius(float x, float y, float r) {
+    std::vector<int> found;
+    this->queryRadius(x, y, r, found);
+    return found;
+}
+
+float Aquarium::getMaxCollisionRadius() {
+    if (m_gridDirty) { this->refreshGridInputs(); this->rebuildGrid(); }
+    return m_maxCollisionRadius;
+}
+
+void Aquarium::removeCreature(std::shared_ptr<Creature> creature) {
+    if (!creature) return;
+    int slot = creature->getStoreSlot();
+    if (slot < 0 || size_t(slot) >= m_creatures.size() || m_creatures[slot] != creature) return; // not in this aquarium
+    this->removeCreature(creature->getHandle());
+}
+
+void Aquarium::removeCreature(CreatureHandle handle) {
+    int slot = this->getSlot(handle);
+    if (slot < 0) return;
+    std::shared_ptr<Creature> creature = m_creatures[slot];
+
+    if(m_store.type[slot]!=AquariumCreatureType::PowerUp &&
+        m_store.type[slot] != AquariumCreatureType::SpeedFruit){
+    SIM_LOG_VERBOSE() << "removing creature " << std::endl;
+    int selectLvl = this->currentLevel % this->m_aquariumlevels.size();
+    this->m_aquariumlevels.at(selectLvl)->ConsumePopulation(m_store.type[slot], m_store.value[slot]);
+        }
+    creature->detachFromStore();
+    creature->setHandle(CreatureHandle());
+    this->releaseHandle(handle.index);
+
+    // swap and pop, the last creature moves into the hole
+    size_t last = m_creatures.size() - 1;
+    if (size_t(slot) != last) {
+        m_creatures[slot] = std::move(m_creatures[last]);
+        m_creatures[slot]->setStoreSlot(slot);
+    }
+    m_creatures.pop_back();
+    m_store.swapRemove(slot);
+    if (size_t(slot) < m_store.size()) {
+        m_handleSlot[m_store.handle[slot]] = slot;
+    }
+    m_gridDirty = true;
+}
+
+void Aquarium::applyCommands() {
+    m_commands.TakeAll(m_applying);
+    for (CreatureCommand& command : m_applying) {
+        switch (command.type) {
+            case CreatureCommandType::Spawn:
+                this->SpawnCreature(command.spawnType);
+                break;
+            case CreatureCommandType::Add:
+                this->addCreature(std::move(command.creature));
+                break;
+            case CreatureCommandType::Remove:
+                this->removeCreature(command.handle);
+                break;
+            case CreatureCommandType::SetPosition:
+                if (std::shared_ptr<Creature> creature = this->getCreature(command.handle)) {
+                    creature->setPosition(command.x, command.y);
+                    m_gridDirty = true;
+                }
+                break;
+            case CreatureCommandType::SetSpeed:
+                if (std::shared_ptr<Creature> creature = this->getCreature(command.handle)) {
+                    creature->setSpeed(command.speed);
+                }
+                break;
+        }
+    }
+    m_applying.clear();
+}
+
+// every block goes back to its slab once nothing else holds the creature,
+// the slabs themselves stay around for the next level's waves
+void Aquarium::clearCreatures() {
+    for (size_t i = 0; i < m_creatures.size(); ++i) {
+        m_creatures[i]->detachFromStore();
+        m_creatures[i]->setHandle(CreatureHandle());
+        this->releaseHandle(m_store.handle[i]);
+    }
+    m_creatures.clear();
+    m_store.clear();
+    m_gridDirty = true;
+}
+
+std::shared_ptr<Creature> Aquarium::getCreatureAt(int index) {
+    if (index < 0 || size_t(index) >= m_creatures.size()) {
+        return nullptr;
+    }
+    return m_creatures[index];
+}
+
+
+
+SpriteHandle Aquarium::spriteFor(AquariumCreatureType type) {
+    if (!m_sprite_source) return nullptr; // headless, nothing to paint
+    return m_sprite_source->GetSprite(type);
+}
+
+void Aquarium::SpawnCreature(AquariumCreatureType type) {
+    Pcg32& random = SimRandom(SimRandomStream::Spawn);
+    int x = random.below(this->getWidth());
+    int y = random.below(this->getHeight());
+    int speed = random.range(1, 25);
+
+    std::shared_ptr<Creature> creature = this->createCreature(type, x, y, speed);
+    if (creature) {
+        this->addCreature(std::move(creature));
+    } else {
+        SIM_LOG_ERROR() << "Unknown creature type to spawn!";
+    }
+}
+
+std::shared_ptr<Creature> Aquarium::createCreature(AquariumCreatureType type, float x, float y, int speed) {
+    switch (type) {
+        case AquariumCreatureType::NPCreature:
+            return MakePooled<NPCreature>(m_pool, x, y, speed, this->spriteFor(AquariumCreatureType::NPCreature));
+        case AquariumCreatureType::BiggerFish:
+            return MakePooled<BiggerFish>(m_pool, x, y, speed, this->spriteFor(AquariumCreatureType::BiggerFish));
+        case AquariumCreatureType::PowerUp:
+            return MakePooled<PowerUp>(m_pool, x, y, this->spriteFor(AquariumCreatureType::PowerUp));
+        case AquariumCreatureType::SpeedFruit:
+            return MakePooled<SpeedFruit>(m_pool, x, y, this->spriteFor(AquariumCreatureType::SpeedFruit));
+        case AquariumCreatureType::GyaradosFish:
+            return MakePooled<GyaradosFish>(m_pool, x, y, speed, this->spriteFor(type));
+        case AquariumCreatureType::AnglerFish:
+            return MakePooled<AnglerFish>(m_pool, x, y, speed, this->spriteFor(AquariumCreatureType::AnglerFish));
+        case AquariumCreatureType::Omanyte:
+            return MakePooled<AnglerFish>(m_pool, x, y, speed, this->spriteFor(AquariumCreatureType::Omanyte));
+        default:
+            return nullptr;
+    }
+}
+
+
+// repopulation will be called from the levl class
+// it will compose into aquarium so eating eats frm the pool of NPCs in the lvl class
+// once lvl criteria met, we move to new lvl through inner signal asking for new lvl
+// which will mean incrementing the buffer and pointing to a new lvl index
+// En Aquarium.cpp - ACTUALIZA el método Repopulate:
+
+void Aquarium::Repopulate(std::shared_ptr<PlayerCreature> player, float deltaTime) {
+    SIM_LOG_VERBOSE() << "entering phase repopulation";
+    
+    int selectedLevelIdx = this->currentLevel % this->m_aquariumlevels.size();
+    SIM_LOG_VERBOSE() << "the current index: " << selectedLevelIdx << std::endl;
+    std::shared_ptr<AquariumLevel> level = this->m_aquariumlevels.at(selectedLevelIdx);
+
+    int previousWave=level->getCurrentWave();
+    level->update(deltaTime,player); 
+
+    
+    if (level->getCurrentWave() > previousWave && level->getCurrentWave() < level->getMaxWaves()) {
+    SIM_LOG_NOTICE() << "Nueva wave: " << level->getCurrentWave();
+    level->spawnWave(shared_from_this());
+    return;
+    } 
+    if (level->getCurrentWave() >=level->getMaxWaves() -1) {
+        if (level->getWaveTimer() >= level->getTimeBetweenWaves() *2.0f) {
+            level->forceFinishLevel();
+
+            // return;
+        }
+    }
+
+    if(level->isCompleted()){
+        SIM_LOG_NOTICE() << "Level " << selectedLevelIdx << " completed! Moving to next level.";
+        level->levelReset();
+        this->currentLevel += 1;
+        selectedLevelIdx = this->currentLevel % this->m_aquariumlevels.size();
+        level = this->m_aquariumlevels.at(selectedLevelIdx);
+        level->initialize(); 
+        this->clearCreatures();
+        this->SpawnCreature(AquariumCreatureType::Omanyte);
+        level->spawnWave(shared_from_this());
+        SIM_LOG_NOTICE() << level->getLevelDescription();
+    }
+
+    
+    std::vector<AquariumCreatureType> toRespawn = level->Repopulate();
+    SIM_LOG_VERBOSE() << "amount to repopulate : " << toRespawn.size() << std::endl;
+    
+    for(AquariumCreatureType newCreatureType : toRespawn){
+        this->SpawnCreature(newCreatureType);
+    }
+    
+}
+
+
+// Aquarium collision detection
+// Broadphase through the aquarium grid: only creatures whose center is close
+// enough to possibly touch the player get the exact check. Every overlap is
+// queued as a COLLISION event (player, creature), lowest index first.
+size_t DetectAquariumCollisions(const std::shared_ptr<Aquarium>& aquarium, const std::shared_ptr<PlayerCreature>& player, SimEventQueue& out) {
+    if (!aquarium || !player) return 0;
+
+    static thread_local std::vector<int> candidates;
+    candidates.clear();
+    float reach = player->getCollisionRadius() + aquarium->getMaxCollisionRadius();
+    aquarium->queryRadius(player->getX(), player->getY(), reach, candidates);
+    std::sort(candidates.begin(), candidates.end());
+
+    // gather the candidates into contiguous arrays for the batched narrowphase,
+    // hits come back as positions in candidates, still in store order
+    static thread_local std::vector<float> candidateX, candidateY, candidateR;
+    static thread_local std::vector<int> hitAt;
+    const CreatureStore& store = aquarium->getStore();
+    candidateX.resize(candidates.size());
+    candidateY.resize(candidates.size());
+    candidateR.resize(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        candidateX[i] = store.x[candidates[i]];
+        candidateY[i] = store.y[candidates[i]];
+        candidateR[i] = store.radius[candidates[i]];
+    }
+    hitAt.clear();
+    size_t hits = OverlapIndices(player->getX(), player->getY(), player->getCollisionRadius(),
+                                 candidateX.data(), candidateY.data(), candidateR.data(), candidates.size(), hitAt);
+    for (int at : hitAt) {
+        out.Push(SimEvent{GameEventType::COLLISION, CreatureHandle(), aquarium->getHandleAt(candidates[at])});
+    }
+    return hits;
+}
+
+// first of the above as a GameEvent, the creature the old linear scan found
+std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player) {
+    static thread_local SimEventQueue events;
+    events.Clear();
+    SimEvent first;
+    if (DetectAquariumCollisions(aquarium, player, events) == 0 || !events.Pop(first)) {
+        return nullptr;
+    }
+    return std::make_shared<GameEvent>(GameEventType::COLLISION, player, aquarium->getCreature(first.handleB));
+}
+
+// adds the table's levels and spawns the opening wave, same for the app and headless runs
+void InitializeAquariumLevels(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player,
+                              std::shared_ptr<const LevelTable> levels) {
+    if (!levels) levels = StockLevelTable();
+    for (size_t i = 0; i < levels->levels.size(); ++i) {
+        aquarium->addAquariumLevel(std::make_shared<AquariumTableLevel>(levels, i));
+    }
+
+    if(aquarium->getLevelCount()>0) {
+        aquarium->getLevel(0)->initialize();
+        aquarium->getLevel(0)->spawnWave(aquarium);
+    }
+
+    aquarium->Repopulate(player);
+}
+
+//  Imlementation of the AquariumSimulation
+
+void AquariumSimulation::Tick(){
+    if (m_replay) {
+        const std::vector<InputEvent>& events = m_replay->events;
+        while (m_replayNext < events.size() && events[m_replayNext].tick <= m_tick) {
+            this->applyKey(events[m_replayNext].key, events[m_replayNext].pressed);
+            ++m_replayNext;
+        }
+    }
+    ++m_tick;
+
+    m_playerPrevX = m_player->getX();
+    m_playerPrevY = m_player->getY();
+    {
+        ProfileScope scope(m_profiler, ProfilePhase::PlayerUpdate);
+        this->m_player->update(m_tickSeconds * BASE_RATE);
+    }
+
+    // a tick longer than the aquarium step (very low tick rates) runs several
+    m_aquariumTimer += m_tickSeconds;
+    while (m_aquariumTimer + 1e-9 >= AQUARIUM_STEP) {
+        m_aquariumTimer -= AQUARIUM_STEP;
+        this->stepAquarium();
+    }
+}
+
+// Collision handling only records what should happen to the aquarium's
+// creatures, the changes land together in applyCommands once the creatures
+// have moved. Repopulate runs after that on the compacted store.
+void AquariumSimulation::stepAquarium(){
+    bool keepGoing;
+    {
+        ProfileScope scope(m_profiler, ProfilePhase::Collision);
+        keepGoing = this->handleCollision();
+    }
+    {
+        ProfileScope scope(m_profiler, ProfilePhase::AquariumUpdate);
+        if (keepGoing) {
+            this->m_aquarium->update(this->m_player);
+        } else {
+            this->m_aquarium->holdPositions();
+        }
+        this->m_aquarium->applyCommands();
+    }
+    if (keepGoing) {
+        ProfileScope scope(m_profiler, ProfilePhase::Repopulate);
+        this->m_aquarium->Repopulate(this->m_player, AQUARIUM_STEP);
+    }
+}
+
+void AquariumSimulation::PressKey(PlayerKey key, bool pressed){
+    if (m_replay) return;
+    if (m_recorder) {
+        m_recorder->events.push_back(InputEvent{m_tick, key, pressed});
+    }
+    this->applyKey(key, pressed);
+}
+
+// Arrow keys: a press turns that axis on keeping the other one, a release
+// turns its axis off. The player also takes a step right away.
+void AquariumSimulation::applyKey(PlayerKey key, bool pressed){
+    PlayerCreature& player = *m_player;
+    float dx = player.isXDirectionActive() ? player.getDx() : 0;
+    float dy = player.isYDirectionActive() ? player.getDy() : 0;
+    switch (key) {
+        case PlayerKey::Up:
+            player.setDirection(dx, pressed ? -1 : 0);
+            break;
+        case PlayerKey::Down:
+            player.setDirection(dx, pressed ? 1 : 0);
+            break;
+        case PlayerKey::Left:
+            player.setDirection(pressed ? -1 : 0, dy);
+            if (pressed) player.setFlipped(true);
+            break;
+        case PlayerKey::Right:
+            player.setDirection(pressed ? 1 : 0, dy);
+            if (pressed) player.setFlipped(false);
+            break;
+        default:
+            return;
+    }
+    player.move();
+}
+
+// creatures only move on aquarium steps, blend from where they were before
+// the last one by how much of the next one has gone by
+float AquariumSimulation::GetAquariumAlpha(float alpha) const {
+    double elapsed = m_aquariumTimer + alpha * m_tickSeconds;
+    return (float)std::min(std::max(elapsed / AQUARIUM_STEP, 0.0), 1.0);
+}
+
+// Drains every collision of this step in one pass. Pickups still skip the
+// rest of the step like they always did; running out of lives ends it.
+bool AquariumSimulation::handleCollision(){
+    CreatureCommandBuffer& commands = this->m_aquarium->getCommands();
+    m_events.Clear();
+    DetectAquariumCollisions(this->m_aquarium, this->m_player, m_events);
+    if (uint32_t dropped = m_events.TakeDropped()) {
+        SIM_LOG_WARNING() << dropped << " collisions didn't fit in the event queue this step";
+    }
+
+    bool keepGoing = true;
+    bool bounced = false;
+    SimEvent event;
+    while (m_events.Pop(event)) {
+        if (event.type != GameEventType::COLLISION) continue;
+        std::shared_ptr<Creature> creature = this->m_aquarium->getCreature(event.handleB);
+        if (creature == nullptr) {
+            SIM_LOG_ERROR() << "Error: collision with a creature that is no longer in the aquarium." << std::endl;
+            continue;
+        }
+        if (creature->getType() == AquariumCreatureType::PowerUp) {
+            m_player->activateSizeBoost();
+            commands.Remove(event.handleB);
+            keepGoing = false;
+            continue;
+        }
+        if (creature->getType() == AquariumCreatureType::SpeedFruit) {
+            m_player->activateSpeedFruit();
+            commands.Remove(event.handleB);
+            keepGoing = false;
+            continue;
+        }
+        if (creature->getType() == AquariumCreatureType::Omanyte){
+            m_player->addLife(1);
+            commands.Remove(event.handleB);
+            SIM_LOG_NOTICE() << "Omanyte eaten! +1 life";
+            keepGoing = false;
+            continue;
+        }
+        SIM_LOG_VERBOSE() << "Collision detected between player and NPC at (" << creature->getX() << ", " << creature->getY() << ")" << std::endl;
+        // one bounce per step, a second flip would cancel the first
+        if (!bounced) {
+            m_player->setDirection(-m_player->getDx(), -m_player->getDy());
+            bounced = true;
+        }
+        if(this->m_player->getPower() < creature->getPowerRequired()){
+            SIM_LOG_NOTICE() << "Player is too weak to eat the creature!" << std::endl;
+            this->m_player->loseLife(3*60); // 3 frames debounce, 3 seconds at 60fps
+            if(this->m_player->getLives() <= 0){
+                this->m_lastEvent = std::make_shared<GameEvent>(GameEventType::GAME_OVER, this->m_player, nullptr);
+                m_events.Clear();
+                return false;
+            }
+            continue;
+        }
+        commands.Remove(event.handleB);
+        this->m_player->addToScore(1, creature->getValue());
+        if (this->m_player->getScore() % 20 == 0) {
+            commands.Spawn(AquariumCreatureType::PowerUp);
+            SIM_LOG_NOTICE() << "A Grow-Grow Devil Fruit appear! ";
+        }
+        if (this->m_player->getScore() % 15 == 0) {
+            commands.Spawn(AquariumCreatureType::SpeedFruit);
+            SIM_LOG_NOTICE() << "A Light-Speed Devil Fruit appeared!";
+        }
+        if (this->m_player->getScore() % 10 == 0 && this->m_player->getScore() > 0) {
+            this->m_player->increasePower(1);
+            SIM_LOG_NOTICE() << "Player grew stronger! New Power: " << this->m_player->getPower() << std::endl;
+        }
+    }
+    return keepGoing;
+}
+
+void AquariumLevel::initialize() {
+    m_level_score = 0;
+    m_currentWave = 0;
+    m_waveTimer = 0.0f;
+    m_levelCompleted = false;
+    populationReset();
+    setupWavePattern();
+}
+void AquariumLevel::update(float deltaTime, std::shared_ptr<PlayerCreature> player) {
+   
+    if (m_levelCompleted) return;
+
+    
+    m_waveTimer += deltaTime;
+
+    
+    if (m_currentWave +1< m_maxWaves && m_waveTimer >= m_timeBetweenWaves) {
+        SIM_LOG_NOTICE() << "[Wave Change] Jumping from wave " << m_currentWave
+                  << " to wave " << (m_currentWave + 1);
+
+        m_waveTimer = 0.0f;
+        m_currentWave++;
+    }
+
+    
+    if (m_level_score >= m_targetScore) {
+        m_levelCompleted = true;
+    }
+}
+
+void AquariumLevel::spawnWave(std::shared_ptr<Aquarium> aquarium) {
+    if (!aquarium) return;
+    
+    std::vector<AquariumCreatureType> waveCreatures = getWaveCreatures(m_currentWave);
+    for (auto creatureType : waveCreatures) {
+        aquarium->SpawnCreature(creatureType);
+    }
+}
+std::vector<AquariumCreatureType> AquariumLevel::Repopulate() {
+    std::vector<AquariumCreatureType> toRepopulate;
+
+    if (m_currentWave >= m_maxWaves) {
+        for (auto& node : m_levelPopulation) {
+            int counter1 = node->population - node->currentPopulation;
+            if (counter1 > 0) {
+                for (int i = 0; i < counter1; i++) {
+                    toRepopulate.push_back(node->creatureType);
+                }
+                node->currentPopulation += counter1;
+            }
+        }
+    }
+    return toRepopulate;
+}
+
+
+
+void AquariumLevel::populationReset(){
+    for(auto node: this->m_levelPopulation){
+        node->currentPopulation = 0; // need to reset the population to ensure they are made a new in the next level
+    }
+}
+
+void AquariumLevel::ConsumePopulation(AquariumCreatureType creatureType, int power){
+    for(std::shared_ptr<AquariumLevelPopulationNode> node: this->m_levelPopulation){
+        SIM_LOG_VERBOSE() << "consuming from this level creatures" << std::endl;
+        if(node->creatureType == creatureType){
+            SIM_LOG_VERBOSE() << "-cosuming from type: " << AquariumCreatureTypeToString(node->creatureType) <<" , currPop: " << node->currentPopulation << std::endl;
+            if(node->currentPopulation > 0){
+                node->currentPopulation -= 1;
+            }
+                m_level_score += power;
+                
+
+             
+            
+            SIM_LOG_VERBOSE() << "+cosuming from type: " << AquariumCreatureTypeToString(node->creatureType) <<" , currPop: " << node->currentPopulation << std::endl;
+            if(m_level_score >= m_targetScore) {
+                    m_levelCompleted = true;
+                }
+            }
+            return;
+        }
+    }
+   
+
+
+bool AquariumLevel::isCompleted() {
+   return m_levelCompleted || m_level_score >= m_targetScore;
+//    return this-> m_level_score >=this-> m_targetScore;
+}
+
+
+
+
+
+AquariumTableLevel::AquariumTableLevel(std::shared_ptr<const LevelTable> table, size_t index)
+: AquariumLevel(table->levels[index].number, table->levels[index].targetScore), m_table(std::move(table)), m_index(index) {
+    const LevelRecord& level = this->record();
+    for (uint32_t i = 0; i < level.populationCount; ++i) {
+        const CreatureCountRecord& population = m_table->populations[level.firstPopulation + i];
+        this->m_levelPopulation.push_back(std::make_shared<AquariumLevelPopulationNode>(AquariumCreatureType(population.type), population.count));
+    }
+}
+
+void AquariumTableLevel::setupWavePattern() {
+    m_maxWaves = (int)this->record().waveCount;
+    m_timeBetweenWaves = this->record().waveSeconds;
+}
+
+// spawns in file order, so a wave comes out the same as it is written
+std::vector<AquariumCreatureType> AquariumTableLevel::getWaveCreatures(int waveNumber) {
+    std::vector<AquariumCreatureType> waveCreatures;
+    const LevelRecord& level = this->record();
+    if (waveNumber < 0 || (uint32_t)waveNumber >= level.waveCount) {
+        return waveCreatures;
+    }
+    const WaveRecord& wave = m_table->waves[level.firstWave + waveNumber];
+    for (uint32_t i = 0; i < wave.spawnCount; ++i) {
+        const CreatureCountRecord& spawn = m_table->spawns[wave.firstSpawn + i];
+        waveCreatures.insert(waveCreatures.end(), spawn.count, AquariumCreatureType(spawn.type));
+    }
+    return waveCreatures;
+}
+
+std::string AquariumTableLevel::getLevelDescription() const {
+    return m_table->getDescription(this->record());
+}
+
+void AquariumTableLevel::spawnWave(std::shared_ptr<Aquarium> aquarium){
+    SIM_LOG_NOTICE() << "[Spawner] Level " << this->getLevelNumber() << " spawneando wave " << m_currentWave;
+    AquariumLevel::spawnWave(aquarium);
+}
\ No newline at end of file
@@ -0,0 +1,482 @@
+#pragma once
+#define NOMINMAX // To avoid min/max macro conflict on Windows
+
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include "SimCore.h"
+#include "SpatialGrid.h"
+#include "SweepAndPrune.h"
+#include "Narrowphase.h"
+#include "MotionKernel.h"
+#include "Schooling.h"
+#include "JobSystem.h"
+#include "CreaturePool.h"
+#include "CreatureCommands.h"
+#include "FrameProfiler.h"
+#include "LevelData.h"
+#include "EventQueue.h"
+#include "SimRandom.h"
+#include "InputLog.h"
+#include "Snapshot.h"
+
+
+enum class AquariumCreatureType {
+    Player,
+    NPCreature,
+    BiggerFish,
+    PowerUp,
+    SpeedFruit,
+    GyaradosFish,
+    AnglerFish,
+    Omanyte
+};
+
+std::string AquariumCreatureTypeToString(AquariumCreatureType t);
+
+class AquariumLevelPopulationNode{
+    public:
+        AquariumLevelPopulationNode() = default;
+        AquariumLevelPopulationNode(AquariumCreatureType creature_type, int population) {
+            this->creatureType = creature_type;
+            this->population = population;
+            this->currentPopulation = 0;
+        };
+        AquariumCreatureType creatureType;
+        int population;
+        int currentPopulation;
+};
+class Aquarium;
+class AquariumLevel;
+class AquariumLevel : public GameLevel {
+
+
+    protected:
+        std::vector<std::shared_ptr<AquariumLevelPopulationNode>> m_levelPopulation;
+        int m_level_score;
+        int m_targetScore;
+        int m_currentWave;
+        int m_maxWaves;
+        float m_timeBetweenWaves;
+        float m_waveTimer;
+        bool m_levelCompleted;
+        virtual void setupWavePattern() = 0;
+        virtual std::vector<AquariumCreatureType> getWaveCreatures(int waveNumber) = 0;
+
+    public:
+        AquariumLevel(int levelNumber, int targetScore)
+        : GameLevel(levelNumber), m_level_score(0), m_targetScore(targetScore), m_currentWave(0), m_maxWaves(0),
+          m_timeBetweenWaves(0.0f), m_waveTimer(0.0f), m_levelCompleted(false){};
+        void ConsumePopulation(AquariumCreatureType creature, int power);
+        bool isCompleted() override;
+        void populationReset();
+        void levelReset(){m_level_score=0;this->populationReset();}
+        virtual std::vector<AquariumCreatureType> Repopulate();
+        virtual void initialize();
+        virtual void update(float deltaTime, std::shared_ptr<PlayerCreature> player);
+        virtual void spawnWave(std::shared_ptr<Aquarium> aquarium);
+        int getCurrentWave() const { return m_currentWave; }
+        int getMaxWaves() const { return m_maxWaves; }
+        virtual std::string getLevelDescription() const = 0;
+
+        float getWaveTimer() const{return m_waveTimer;}
+        float getTimeBetweenWaves() const{return m_timeBetweenWaves;}
+        int getLevelScore() const{return m_level_score;}
+        int getTargetScore() const{return m_targetScore;}
+        void forceAdvanceWave() {
+            m_waveTimer = 0.0f;
+            m_currentWave++;
+            SIM_LOG_NOTICE() << "Nueva wave -> " << m_currentWave;
+        }
+        void forceFinishLevel() {
+            m_levelCompleted = true;
+        }
+        // wave, timer, score and population counts. Only load a record that
+        // matchesProgress (same populations as this level)
+        SnapshotLevel saveProgress(std::vector<SnapshotPopulation>& populations) const;
+        bool matchesProgress(const SnapshotLevel& progress, const SnapshotPopulation* populations) const;
+        void loadProgress(const SnapshotLevel& progress, const SnapshotPopulation* populations);
+
+};
+
+
+class PlayerCreature : public Creature {
+public:
+
+    PlayerCreature(float x, float y, int speed, SpriteHandle sprite);
+    void move();
+    // frames: how many 60 Hz frames this call stands for, speeds and timers
+    // are tuned per frame and scale with it
+    void update(float frames = 1.0f);
+    void changeSpeed(int speed);
+    void setLives(int lives) { m_lives = lives; }
+    void setDirection(float dx, float dy);
+    float isXDirectionActive() { return velX() != 0; }
+    float isYDirectionActive() {return velY() != 0; }
+    float getDx() { return velX(); }
+    float getDy() { return velY(); }
+
+    int getScore()const { return m_score; }
+    int getLives() const { return m_lives; }
+    int getPower() const { return m_power; }
+    bool isInDamageDebounce() const { return m_damage_debounce > 0; }
+    bool isSizeBoostActive() const { return m_sizeActive; }
+
+    void addToScore(int amount, int weight=1) { m_score += amount * weight; }
+    void loseLife(int debounce);
+    void increasePower(int value) { m_power += value; }
+    void reduceDamageDebounce();
+    void activateSizeBoost();
+    void updateSizeBoost();
+    void activateSpeedFruit();
+    void updateSpeedFruit();
+    // everything but the sprite and bounds, for save states
+    SnapshotPlayer saveState() const;
+    void loadState(const SnapshotPlayer& state);
+    void addLife(int amount = 1){
+        if (m_lives <3){
+            m_lives += amount;
+            if (m_lives >3) m_lives =3;
+            SIM_LOG_NOTICE() << "Player gained a life!" << std::endl;
+        } else{
+            SIM_LOG_NOTICE() << "Lives are already at the maximum!"<<std::endl;
+        }
+    }
+
+private:
+    int m_score = 0;
+    int m_lives = 3;
+    int m_power = 1; // mark current power lvl
+    float m_damage_debounce = 0; // frames to wait after eating
+    float m_stepFrames = 1.0f; // frames the current update() covers
+    bool m_sizeActive=false;
+    float m_sizeScale=1.0;
+    float m_sizeTimer=0;
+    const int m_sizeDuration= 15*60;
+    float m_defaultCollisionRad=25.0;
+    bool m_speedFruitActive=false;
+    float m_speedFruitTime=0;
+    const int m_speedFruitDuration=7*60;
+    int m_speedNormal=0;
+};
+class NPCreature : public Creature {
+public:
+    NPCreature(float x, float y, int speed, SpriteHandle sprite);
+    AquariumCreatureType GetType() {return this->m_creatureType;}
+    void move() override;
+    CreatureMotion getMotion() const override { return CreatureMotion::Passive; }
+
+    int getPowerRequired() const {return m_powerRequired;}
+protected:
+    AquariumCreatureType m_creatureType;
+};
+
+class BiggerFish : public NPCreature {
+public:
+    BiggerFish(float x, float y, int speed, SpriteHandle sprite);
+    void move() override;
+    float getPassiveSpeedScale() const override { return 0.5f; } // Moves at half speed
+};
+class GyaradosFish : public NPCreature {
+    public:
+    GyaradosFish(float x, float y, int speed, SpriteHandle sprite);
+    void move(const std::shared_ptr<PlayerCreature>& player) override;
+    CreatureMotion getMotion() const override { return CreatureMotion::Custom; }
+};
+class PowerUp : public Creature{
+public:
+    PowerUp(float x, float y, SpriteHandle sprite)
+        : Creature(x, y, 0, 20.0f, 0, sprite)
+    {
+        m_type = AquariumCreatureType::PowerUp;
+    }
+
+    void move() override {};
+    CreatureMotion getMotion() const override { return CreatureMotion::Static; }
+};
+class SpeedFruit : public Creature{
+public:
+    SpeedFruit(float x, float y, SpriteHandle sprite)
+        : Creature(x, y, 0, 20.0f, 0, sprite){
+        m_type= AquariumCreatureType::SpeedFruit;
+    }
+    void move() override {}
+    CreatureMotion getMotion() const override { return CreatureMotion::Static; }
+};
+class Omanyte : public NPCreature {
+public:
+    Omanyte(float x, float y, int speed, SpriteHandle sprite)
+        : NPCreature(x, y, speed, sprite)
+    {
+        m_type = AquariumCreatureType::Omanyte;
+        setCollisionRadius(35.0f);
+    }
+};
+class AnglerFish : public NPCreature{
+    public:
+    AnglerFish(float x, float y, int speed, SpriteHandle sprite)
+        : NPCreature(x, y, speed, sprite) {
+        m_value = 4;
+        m_type = AquariumCreatureType::AnglerFish;
+        m_powerRequired=2;
+    }
+
+  static constexpr float FLEE_RADIUS = 150.0f;
+
+  CreatureMotion getMotion() const override { return CreatureMotion::Custom; }
+
+  void move(const std::shared_ptr<PlayerCreature>& player) {
+        float dx = player->getX() - posX();
+        float dy = player->getY() - posY();
+        float distSq = dx*dx + dy*dy;
+
+        // squared compare first, the sqrt is only needed when actually fleeing
+        if (distSq < FLEE_RADIUS*FLEE_RADIUS && distSq > 0) {
+            float distancia = sqrt(distSq);
+            velX() = -dx/distancia;
+            velY() = -dy/distancia;
+            posX() += velX()* (m_speed*1.6f);
+            posY() += velY()* (m_speed*1.6f);
+        } else {
+        posX() += velX() * m_speed;
+        posY() += velY() * m_speed;
+        }
+        setFlipped(velX() < 0);
+        bounce();
+    }
+};
+
+// Where spawned creatures get their sprite from. The app hands in its
+// AquariumSpriteManager, headless runs pass nullptr and creatures get no sprite.
+class CreatureSpriteSource {
+    public:
+        virtual ~CreatureSpriteSource() = default;
+        virtual SpriteHandle GetSprite(AquariumCreatureType t) = 0;
+};
+
+
+class Aquarium :public std::enable_shared_from_this<Aquarium>{
+public:
+    Aquarium(int width, int height, std::shared_ptr<CreatureSpriteSource> spriteSource);
+    CreatureHandle addCreature(std::shared_ptr<Creature> creature);
+    void addAquariumLevel(std::shared_ptr<AquariumLevel> level);
+    // O(1), the last creature takes the removed one's slot. Stale handles
+    // and creatures from other aquariums are ignored
+    void removeCreature(CreatureHandle handle);
+    void removeCreature(std::shared_ptr<Creature> creature);
+    void clearCreatures();
+    void update(std::shared_ptr<PlayerCreature> player);
+    // prevX/prevY = x/y, for a step that skips update so drawing doesn't
+    // blend from the step before
+    void holdPositions();
+    void setBounds(int w, int h);
+    void setMaxPopulation(int n) { m_maxPopulation = n; }
+    // deltaTime: seconds of game time since the last call, drives the waves
+    void Repopulate(std::shared_ptr<PlayerCreature> player, float deltaTime = 1.0f/60.0f);
+    void SpawnCreature(AquariumCreatureType type);
+    // a creature of that type from the pool, not added yet. nullptr for
+    // types that can't be spawned
+    std::shared_ptr<Creature> createCreature(AquariumCreatureType type, float x, float y, int speed);
+
+    // Deferred changes: record them any time during a tick (from any thread),
+    // they take effect in order when applyCommands() runs at the tick's end.
+    CreatureCommandBuffer& getCommands() { return m_commands; }
+    void applyCommands();
+
+    std::shared_ptr<Creature> getCreatureAt(int index);
+    CreatureHandle getHandleAt(int index) const;
+    // nullptr / -1 once the creature has been removed
+    bool isValid(CreatureHandle handle) const { return getSlot(handle) >= 0; }
+    std::shared_ptr<Creature> getCreature(CreatureHandle handle) const;
+    int getSlot(CreatureHandle handle) const;
+    const std::vector<std::shared_ptr<Creature>>& getCreatures() const { return m_creatures; }
+    // hot creature data, slot i is getCreatureAt(i)
+    const CreatureStore& getStore() const { return m_store; }
+    int getCreatureCount() const { return m_creatures.size(); }
+    // where SpawnCreature allocates from, blocks come back as creatures die
+    const CreaturePool& getCreaturePool() const { return *m_pool; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getCurrentLevelIndex() const{return currentLevel;}
+    void setCurrentLevelIndex(int index){currentLevel = index;}
+    int getLevelCount() const{return m_aquariumlevels.size();}
+    std::shared_ptr<AquariumLevel> getLevel(int index) const{return m_aquariumlevels.at(index); }
+
+    // indices (for getCreatureAt) of the creatures whose center is within r of (x, y)
+    std::vector<int> queryRadius(float x, float y, float r);
+    void queryRadius(float x, float y, float r, std::vector<int>& out);
+    float getMaxCollisionRadius();
+    void setGridCellSize(float cellSize);
+
+    // NPC vs NPC contact, off by default. When enabled, update() collects every
+    // overlapping pair of creatures (pickups excluded) and can push them apart.
+    void setNPCCollisionsEnabled(bool enabled) { m_npcCollisions = enabled; }
+    void setNPCSeparationEnabled(bool enabled) { m_npcSeparation = enabled; }
+    bool isNPCCollisionsEnabled() const { return m_npcCollisions; }
+    const std::vector<SweepAndPrune::Pair>& getNPCOverlaps() const { return m_npcOverlaps; }
+
+    // kernel that moves the passive creatures, the best one the cpu has by
+    // default. Mostly for the bench, all of them give the same result
+    void setMotionKernel(MotionKernel kernel) { m_motionKernel = kernel; }
+    MotionKernel getMotionKernel() const { return m_motionKernel; }
+
+    // Boids schooling for the base fish (NPCreature), off by default. When
+    // on, update() turns them before they move, see SchoolOfFish.
+    void setSchoolingEnabled(bool enabled) { m_schooling = enabled; }
+    bool isSchoolingEnabled() const { return m_schooling; }
+    void setSchoolingParams(const SchoolingParams& params) { m_school.SetParams(params); }
+    const SchoolingParams& getSchoolingParams() const { return m_school.GetParams(); }
+
+private:
+    // creatures per job when update() splits the move pass across threads,
+    // below this it isn't worth waking anyone
+    static constexpr size_t MOVE_CHUNK = 4096;
+
+    SpriteHandle spriteFor(AquariumCreatureType type);
+    void moveCreatures(std::shared_ptr<PlayerCreature> player);
+    void refreshGridInputs();
+    void rebuildGrid();
+    void resolveNPCCollisions();
+    CreatureHandle acquireHandle(int slot);
+    void releaseHandle(uint32_t index);
+
+    int m_maxPopulation = 0;
+    int m_width;
+    int m_height;
+    int currentLevel = 0;
+    std::vector<std::shared_ptr<Creature>> m_creatures; // facades, same order as m_store
+    CreatureStore m_store;
+    // handle table: slot of each entry (-1 when free) and its generation
+    std::vector<int> m_handleSlot;
+    std::vector<uint32_t> m_handleGeneration;
+    std::vector<uint32_t> m_freeHandles;
+    CreatureCommandBuffer m_commands;
+    std::vector<CreatureCommand> m_applying; // scratch for applyCommands
+    std::vector<std::shared_ptr<AquariumLevel>> m_aquariumlevels;
+    std::shared_ptr<CreatureSpriteSource> m_sprite_source;
+    std::shared_ptr<CreaturePool> m_pool = std::make_shared<CreaturePool>();
+
+    // broadphase, rebuilt after creatures move and lazily after adds/removes
+    SpatialGrid m_grid;
+    float m_gridCellSize = 128.0f;
+    bool m_gridDirty = true;
+    float m_maxCollisionRadius = 0.0f;
+    std::vector<unsigned char> m_isPickup;
+
+    bool m_npcCollisions = false;
+    bool m_npcSeparation = false;
+    SweepAndPrune m_sweep;
+    std::vector<SweepAndPrune::Pair> m_npcOverlaps;
+
+    MotionKernel m_motionKernel = BestMotionKernel();
+
+    bool m_schooling = false;
+    SchoolOfFish m_school;
+};
+
+
+// queues a COLLISION event for every creature touching the player, lowest
+// store index first, and returns how many it found
+size_t DetectAquariumCollisions(const std::shared_ptr<Aquarium>& aquarium, const std::shared_ptr<PlayerCreature>& player, SimEventQueue& out);
+// just the first of those, nullptr when there is none
+std::shared_ptr<GameEvent> DetectAquariumCollisions(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player);
+
+// adds a level per table row (the stock levels when levels is null) and
+// spawns the first wave
+void InitializeAquariumLevels(std::shared_ptr<Aquarium> aquarium, std::shared_ptr<PlayerCreature> player,
+                              std::shared_ptr<const LevelTable> levels = nullptr);
+
+
+// One game tick of the aquarium: player movement, collisions, eating and
+// repopulation. AquariumGameScene drives it once per frame, headless runs
+// drive it as fast as they like.
+// One Tick is one fixed step of TickRate Hz (60 by default). Player speeds
+// and timers are tuned per 60 Hz frame and get scaled to the tick, the
+// aquarium (collisions, fish, waves) steps every AQUARIUM_STEP seconds of
+// game time. Any tick rate plays the same game, only finer or coarser.
+class AquariumSimulation {
+    public:
+        static constexpr float BASE_RATE = 60.0f;
+        static constexpr double AQUARIUM_STEP = 0.1; // every 6th frame at 60 Hz, like before
+
+        AquariumSimulation(std::shared_ptr<PlayerCreature> player, std::shared_ptr<Aquarium> aquarium)
+        : m_player(std::move(player)), m_aquarium(std::move(aquarium)){}
+        void Tick();
+        void SetTickRate(float hz) { m_tickSeconds = 1.0 / std::max(hz, 1.0f); }
+        float GetTickRate() const { return 1.0 / m_tickSeconds; }
+        double GetTickSeconds() const { return m_tickSeconds; }
+
+        // For drawing between ticks: alpha is how far (0..1) real time is into
+        // the next tick, see FixedTimestep::getAlpha
+        float GetAquariumAlpha(float alpha) const;
+        float GetPlayerDrawX(float alpha) const { return m_playerPrevX + (m_player->getX() - m_playerPrevX) * alpha; }
+        float GetPlayerDrawY(float alpha) const { return m_playerPrevY + (m_player->getY() - m_playerPrevY) * alpha; }
+
+        std::shared_ptr<GameEvent> GetLastEvent(){return m_lastEvent;}
+        void SetLastEvent(std::shared_ptr<GameEvent> event){this->m_lastEvent = event;}
+        std::shared_ptr<PlayerCreature> GetPlayer(){return this->m_player;}
+        std::shared_ptr<Aquarium> GetAquarium(){return this->m_aquarium;}
+        // times player update, collision, aquarium update and repopulate
+        // into it, may be nullptr
+        void SetProfiler(FrameProfiler* profiler){this->m_profiler = profiler;}
+
+        // Steering keys go through here so they land between ticks and can
+        // be recorded. While a replay is set these are ignored, the log
+        // presses the keys instead.
+        void PressKey(PlayerKey key, bool pressed);
+        // ticks run so far, what input events are stamped with
+        uint32_t GetTickCount() const { return m_tick; }
+        // appends every key to log->events (the caller fills in the header), may be nullptr
+        void SetRecorder(InputLog* log){this->m_recorder = log;}
+        // presses the log's keys at their ticks, may be nullptr. The log
+        // has to outlive the replay.
+        void SetReplay(const InputLog* log){this->m_replay = log; this->m_replayNext = 0;}
+        bool IsReplayFinished() const { return m_replay != nullptr && m_tick >= m_replay->tickCount; }
+
+        // Save states (see Snapshot.h), between ticks. Loading replaces the
+        // creatures, player, level progress, clock and random streams; it
+        // needs the same level table the snapshot was taken with and leaves
+        // everything as it was on failure. It is refused while recording or
+        // replaying, an input log can't express the jump.
+        bool SaveSnapshot(const std::string& path) const;
+        bool LoadSnapshot(const std::string& path);
+    private:
+        std::shared_ptr<PlayerCreature> m_player;
+        std::shared_ptr<Aquarium> m_aquarium;
+        std::shared_ptr<GameEvent> m_lastEvent;
+        double m_tickSeconds = 1.0 / BASE_RATE;
+        double m_aquariumTimer = 0.0; // game time since the last aquarium step
+        float m_playerPrevX = 0.0f;
+        float m_playerPrevY = 0.0f;
+        FrameProfiler* m_profiler = nullptr;
+        SimEventQueue m_events; // this step's collisions, drained by handleCollision
+        uint32_t m_tick = 0;
+        InputLog* m_recorder = nullptr;
+        const InputLog* m_replay = nullptr;
+        size_t m_replayNext = 0; // first replay event not pressed yet
+
+        void stepAquarium();
+        void applyKey(PlayerKey key, bool pressed);
+        bool handleCollision(); // false when the rest of the tick should be skipped
+};
+
+
+// A level read from a LevelTable row: population, waves and target score
+// all come from the data file (see LevelData.h)
+class AquariumTableLevel : public AquariumLevel  {
+    public:
+        AquariumTableLevel(std::shared_ptr<const LevelTable> table, size_t index);
+
+        void spawnWave(std::shared_ptr<Aquarium> aquarium) override;
+        void setupWavePattern() override;
+        std::vector<AquariumCreatureType> getWaveCreatures(int waveNumber) override;
+        std::string getLevelDescription() const override;
+
+    private:
+        const LevelRecord& record() const { return m_table->levels[m_index]; }
+
+        std::shared_ptr<const LevelTable> m_table;
+        size_t m_index;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "CreatureStore.h"
+
+class Creature;
+
+// Changes to an aquarium's creature list recorded during a tick and applied
+// together at the end of it (Aquarium::applyCommands), so nothing adds or
+// removes creatures while the move pass or the collision code is walking the
+// store. Commands are plain values kept in recording order.
+enum class CreatureCommandType {
+    Spawn,       // SpawnCreature(spawnType)
+    Add,         // addCreature(creature)
+    Remove,      // removeCreature(handle)
+    SetPosition, // handle's creature to (x, y)
+    SetSpeed     // handle's creature to speed
+};
+
+struct CreatureCommand {
+    CreatureCommandType type;
+    AquariumCreatureType spawnType;
+    CreatureHandle handle;
+    std::shared_ptr<Creature> creature;
+    float x = 0.0f;
+    float y = 0.0f;
+    int speed = 0;
+};
+
+// Recording is thread safe, worker threads may queue while the move pass
+// runs. The vector keeps its capacity between ticks.
+class CreatureCommandBuffer {
+public:
+    void Spawn(AquariumCreatureType type) { push(CreatureCommand{CreatureCommandType::Spawn, type, CreatureHandle(), nullptr}); }
+    void Add(std::shared_ptr<Creature> creature) { push(CreatureCommand{CreatureCommandType::Add, AquariumCreatureType(0), CreatureHandle(), std::move(creature)}); }
+    void Remove(CreatureHandle handle) { push(CreatureCommand{CreatureCommandType::Remove, AquariumCreatureType(0), handle, nullptr}); }
+    void SetPosition(CreatureHandle handle, float x, float y) { push(CreatureCommand{CreatureCommandType::SetPosition, AquariumCreatureType(0), handle, nullptr, x, y}); }
+    void SetSpeed(CreatureHandle handle, int speed) { push(CreatureCommand{CreatureCommandType::SetSpeed, AquariumCreatureType(0), handle, nullptr, 0.0f, 0.0f, speed}); }
+
+    // hands the recorded commands over and leaves the buffer empty
+    void TakeAll(std::vector<CreatureCommand>& out) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        out.swap(m_commands);
+        m_commands.clear();
+    }
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_commands.size();
+    }
+
+private:
+    void push(CreatureCommand command) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_commands.push_back(std::move(command));
+    }
+
+    std::mutex m_lock;
+    std::vector<CreatureCommand> m_commands;
+};
@@ -0,0 +1,65 @@
+#include "CreaturePool.h"
+#include <new>
+#include <algorithm>
+
+
+std::atomic<int> CreaturePool::s_nextSlabId{0};
+
+CreaturePool::~CreaturePool() {
+    for (Slab& slab : m_slabs) {
+        for (void* chunk : slab.chunks) {
+            ::operator delete(chunk);
+        }
+    }
+}
+
+void* CreaturePool::Allocate(int slabId, size_t size) {
+    if ((size_t)slabId >= m_slabs.size()) {
+        m_slabs.resize(slabId + 1);
+    }
+    Slab& slab = m_slabs[slabId];
+    if (slab.blockSize == 0) {
+        // room for the free list link, every block keeps max_align_t alignment
+        const size_t align = alignof(std::max_align_t);
+        slab.blockSize = (std::max(size, sizeof(void*)) + align - 1) / align * align;
+    }
+    if (slab.freeList == nullptr) {
+        this->grow(slab);
+    }
+    void* block = slab.freeList;
+    slab.freeList = *static_cast<void**>(block);
+    ++slab.live;
+    return block;
+}
+
+void CreaturePool::Deallocate(int slabId, void* block) {
+    Slab& slab = m_slabs[slabId];
+    *static_cast<void**>(block) = slab.freeList;
+    slab.freeList = block;
+    --slab.live;
+}
+
+// one chunk of BLOCKS_PER_CHUNK blocks, threaded onto the free list in
+// address order so fresh creatures sit next to each other
+void CreaturePool::grow(Slab& slab) {
+    char* chunk = static_cast<char*>(::operator new(slab.blockSize * BLOCKS_PER_CHUNK));
+    slab.chunks.push_back(chunk);
+    for (size_t i = BLOCKS_PER_CHUNK; i > 0; --i) {
+        void* block = chunk + (i - 1) * slab.blockSize;
+        *static_cast<void**>(block) = slab.freeList;
+        slab.freeList = block;
+    }
+    slab.reserved += BLOCKS_PER_CHUNK;
+}
+
+size_t CreaturePool::GetLiveCount() const {
+    size_t live = 0;
+    for (const Slab& slab : m_slabs) live += slab.live;
+    return live;
+}
+
+size_t CreaturePool::GetReservedCount() const {
+    size_t reserved = 0;
+    for (const Slab& slab : m_slabs) reserved += slab.reserved;
+    return reserved;
+}
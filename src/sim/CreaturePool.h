@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Slab allocator for creatures. Every creature type gets its own slab of
+// fixed-size blocks handed out from a free list, blocks go back on the list
+// when the last shared_ptr to the creature is dropped. Chunks are only ever
+// added, so once a level has seen its biggest wave spawning and removing
+// creatures doesn't touch malloc.
+//
+// Creatures are made with MakePooled, which puts the shared_ptr control
+// block and the creature in one block. The allocator copy stored in that
+// control block keeps the pool alive, so an event can still hold a creature
+// after its aquarium is gone. Not thread safe: spawn and remove on one thread.
+class CreaturePool {
+public:
+    CreaturePool() = default;
+    ~CreaturePool();
+    CreaturePool(const CreaturePool&) = delete;
+    CreaturePool& operator=(const CreaturePool&) = delete;
+
+    void* Allocate(int slabId, size_t size);
+    void Deallocate(int slabId, void* block);
+
+    // blocks handed out and not returned yet / blocks owned, over all slabs
+    size_t GetLiveCount() const;
+    size_t GetReservedCount() const;
+
+    // small dense id per allocated type, used to pick its slab
+    template <typename T>
+    static int SlabId() {
+        static const int id = s_nextSlabId++;
+        return id;
+    }
+
+private:
+    struct Slab {
+        size_t blockSize = 0;
+        void* freeList = nullptr; // each free block starts with the next one
+        std::vector<void*> chunks;
+        size_t live = 0;
+        size_t reserved = 0;
+    };
+    static constexpr size_t BLOCKS_PER_CHUNK = 64;
+    static std::atomic<int> s_nextSlabId;
+
+    void grow(Slab& slab);
+
+    std::vector<Slab> m_slabs;
+};
+
+template <typename T>
+class CreaturePoolAllocator {
+public:
+    using value_type = T;
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned creatures need their own slab alignment");
+
+    explicit CreaturePoolAllocator(std::shared_ptr<CreaturePool> pool) : m_pool(std::move(pool)) {}
+    template <typename U>
+    CreaturePoolAllocator(const CreaturePoolAllocator<U>& other) : m_pool(other.m_pool) {}
+
+    T* allocate(size_t n) {
+        if (n != 1) return std::allocator<T>().allocate(n);
+        return static_cast<T*>(m_pool->Allocate(CreaturePool::SlabId<T>(), sizeof(T)));
+    }
+    void deallocate(T* block, size_t n) {
+        if (n != 1) { std::allocator<T>().deallocate(block, n); return; }
+        m_pool->Deallocate(CreaturePool::SlabId<T>(), block);
+    }
+
+    template <typename U>
+    bool operator==(const CreaturePoolAllocator<U>& other) const { return m_pool == other.m_pool; }
+    template <typename U>
+    bool operator!=(const CreaturePoolAllocator<U>& other) const { return m_pool != other.m_pool; }
+
+private:
+    template <typename U> friend class CreaturePoolAllocator;
+    std::shared_ptr<CreaturePool> m_pool;
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> MakePooled(const std::shared_ptr<CreaturePool>& pool, Args&&... args) {
+    return std::allocate_shared<T>(CreaturePoolAllocator<T>(pool), std::forward<Args>(args)...);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Rendering resource owned by the app layer (see Core.h). The simulation only
+// carries it around so the renderer knows what to paint for each creature.
+// Sprites are loaded once and shared by every creature of a kind, so anything
+// that changes per creature (like facing left) lives on the Creature instead.
+class GameSprite;
+using SpriteHandle = std::shared_ptr<const GameSprite>;
+
+enum class AquariumCreatureType:int;
+
+// How Aquarium::update advances a creature.
+enum class CreatureMotion : unsigned char {
+    Static,  // never moves (pickups)
+    Passive, // straight line at step px per tick, bouncing off the walls
+    Custom   // needs its virtual move(player), e.g. chasing or fleeing
+};
+
+// Stable name for a creature inside one aquarium, safe to keep around after
+// the creature is gone. index picks an entry of the aquarium's handle table
+// and generation has to match that entry, removing a creature bumps it so
+// old handles stop resolving even once the entry is reused.
+struct CreatureHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool isNull() const { return index == UINT32_MAX; }
+    bool operator==(const CreatureHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const CreatureHandle& other) const { return !(*this == other); }
+};
+
+// Structure-of-arrays storage for the creatures of one aquarium. Slot i of
+// every array belongs to the same creature, and slots are kept in the same
+// order as Aquarium's creature list so loops over them run linearly.
+// Removal moves the last slot into the hole, so slots are not stable, keep
+// a CreatureHandle to refer to a creature over time.
+//
+// x/y/dx/dy/radius/flipped/sprite/value are the live values: a Creature
+// inside an aquarium reads and writes them through its accessors. The rest
+// are copied in when the creature is added (type and motion never change
+// after that, step and bounds are refreshed by the Creature setters). handle is the
+// handle table entry of the creature in each slot. prevX/prevY are where the
+// creature was before the last Aquarium::update, for drawing in between.
+class CreatureStore {
+public:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> dx;
+    std::vector<float> dy;
+    std::vector<float> radius;
+    std::vector<unsigned char> flipped;
+    std::vector<SpriteHandle> sprite;
+
+    std::vector<float> step;
+    std::vector<float> boundW;
+    std::vector<float> boundH;
+    std::vector<AquariumCreatureType> type;
+    std::vector<CreatureMotion> motion;
+    std::vector<int> value;
+    std::vector<uint32_t> handle;
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    // appends a zeroed slot and returns its index
+    int push() {
+        x.push_back(0); y.push_back(0); dx.push_back(0); dy.push_back(0);
+        radius.push_back(0); flipped.push_back(0); sprite.push_back(nullptr);
+        step.push_back(0); boundW.push_back(0); boundH.push_back(0);
+        type.push_back(AquariumCreatureType(0)); motion.push_back(CreatureMotion::Custom); value.push_back(0);
+        handle.push_back(UINT32_MAX); prevX.push_back(0); prevY.push_back(0);
+        return x.size() - 1;
+    }
+
+    // removes a slot in O(1) by moving the last slot into it
+    void swapRemove(size_t slot) {
+        size_t last = size() - 1;
+        if (slot != last) {
+            x[slot] = x[last]; y[slot] = y[last]; dx[slot] = dx[last]; dy[slot] = dy[last];
+            radius[slot] = radius[last]; flipped[slot] = flipped[last]; sprite[slot] = std::move(sprite[last]);
+            step[slot] = step[last]; boundW[slot] = boundW[last]; boundH[slot] = boundH[last];
+            type[slot] = type[last]; motion[slot] = motion[last]; value[slot] = value[last];
+            handle[slot] = handle[last]; prevX[slot] = prevX[last]; prevY[slot] = prevY[last];
+        }
+        x.pop_back(); y.pop_back(); dx.pop_back(); dy.pop_back();
+        radius.pop_back(); flipped.pop_back(); sprite.pop_back();
+        step.pop_back(); boundW.pop_back(); boundH.pop_back();
+        type.pop_back(); motion.pop_back(); value.pop_back();
+        handle.pop_back(); prevX.pop_back(); prevY.pop_back();
+    }
+
+    void clear() {
+        x.clear(); y.clear(); dx.clear(); dy.clear();
+        radius.clear(); flipped.clear(); sprite.clear();
+        step.clear(); boundW.clear(); boundH.clear();
+        type.clear(); motion.clear(); value.clear();
+        handle.clear(); prevX.clear(); prevY.clear();
+    }
+};
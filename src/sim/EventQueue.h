@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "CreatureStore.h"
+#include "SimCore.h"
+
+// Fixed-capacity FIFO over an inline array. Push fails when full instead of
+// growing, so a queue never allocates once it exists.
+template <typename T, size_t Capacity>
+class RingBuffer {
+public:
+    static constexpr size_t CAPACITY = Capacity;
+
+    bool Push(const T& value) {
+        if (m_size == Capacity) return false;
+        m_items[(m_head + m_size) % Capacity] = value;
+        ++m_size;
+        return true;
+    }
+    // oldest first, false when empty
+    bool Pop(T& out) {
+        if (m_size == 0) return false;
+        out = m_items[m_head];
+        m_head = (m_head + 1) % Capacity;
+        --m_size;
+        return true;
+    }
+    void Clear() { m_head = 0; m_size = 0; }
+
+    size_t Size() const { return m_size; }
+    bool IsEmpty() const { return m_size == 0; }
+    bool IsFull() const { return m_size == Capacity; }
+
+private:
+    std::array<T, Capacity> m_items{};
+    size_t m_head = 0;
+    size_t m_size = 0;
+};
+
+// What the simulation hands around within a tick. Plain values: creatures
+// are named by their aquarium handle (null for the player, who isn't in the
+// store), so a stale event can't reach a fish that has been replaced.
+struct SimEvent {
+    GameEventType type = GameEventType::NONE;
+    CreatureHandle handleA;
+    CreatureHandle handleB;
+};
+
+// Events of one aquarium step. Every overlap is queued, the collision pass
+// drains them in order; anything past the capacity is counted as dropped.
+class SimEventQueue {
+public:
+    static constexpr size_t CAPACITY = 256;
+
+    void Push(const SimEvent& event) {
+        if (!m_events.Push(event)) ++m_dropped;
+    }
+    bool Pop(SimEvent& out) { return m_events.Pop(out); }
+    void Clear() { m_events.Clear(); }
+    size_t Size() const { return m_events.Size(); }
+
+    // events lost to a full queue since the last TakeDropped
+    uint32_t TakeDropped() { uint32_t dropped = m_dropped; m_dropped = 0; return dropped; }
+
+private:
+    RingBuffer<SimEvent, CAPACITY> m_events;
+    uint32_t m_dropped = 0;
+};
@@ -0,0 +1,65 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+
+
+const char* ProfilePhaseToString(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::Input: return "input";
+        case ProfilePhase::PlayerUpdate: return "player update";
+        case ProfilePhase::Collision: return "collision";
+        case ProfilePhase::AquariumUpdate: return "aquarium update";
+        case ProfilePhase::Repopulate: return "repopulate";
+        case ProfilePhase::Draw: return "draw";
+        case ProfilePhase::Hud: return "hud";
+        default: return "";
+    }
+}
+
+// turning it back on starts a fresh history instead of mixing in old frames
+void FrameProfiler::SetEnabled(bool enabled) {
+    if (enabled && !m_enabled) {
+        m_started = false;
+        m_next = 0;
+        m_count = 0;
+        m_current.fill(0.0);
+    }
+    m_enabled = enabled;
+}
+
+void FrameProfiler::NextFrame() {
+    if (!m_enabled) return;
+    Clock::time_point now = Clock::now();
+    if (m_started) {
+        m_frames[m_next] = std::chrono::duration<double>(now - m_frameStart).count();
+        m_phases[m_next] = m_current;
+        m_next = (m_next + 1) % HISTORY;
+        m_count = std::min(m_count + 1, HISTORY);
+    }
+    m_current.fill(0.0);
+    m_frameStart = now;
+    m_started = true;
+}
+
+double FrameProfiler::GetPhaseAverageMs(ProfilePhase phase) const {
+    if (m_count == 0) return 0.0;
+    double total = 0.0;
+    for (size_t i = 0; i < m_count; ++i) {
+        total += m_phases[i][(size_t)phase];
+    }
+    return total / m_count * 1000.0;
+}
+
+double FrameProfiler::GetFramePercentileMs(double percentile) const {
+    if (m_count == 0) return 0.0;
+    std::array<double, HISTORY> sorted;
+    std::copy(m_frames.begin(), m_frames.begin() + m_count, sorted.begin());
+    size_t rank = std::min(m_count - 1, (size_t)(percentile * (m_count - 1) + 0.5));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + m_count);
+    return sorted[rank] * 1000.0;
+}
+
+double FrameProfiler::GetFrameMs(size_t i) const {
+    if (i >= m_count) return 0.0;
+    size_t oldest = m_count < HISTORY ? 0 : m_next;
+    return m_frames[(oldest + i) % HISTORY] * 1000.0;
+}
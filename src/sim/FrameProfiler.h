@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// What the profiler overlay splits a frame into.
+enum class ProfilePhase {
+    Input,
+    PlayerUpdate,
+    Collision,
+    AquariumUpdate,
+    Repopulate,
+    Draw,
+    Hud,
+    Count
+};
+
+const char* ProfilePhaseToString(ProfilePhase phase);
+
+// Rolling per-phase timings and frame times over the last HISTORY frames.
+// Code adds time to a phase with a ProfileScope, NextFrame() closes the
+// current frame. Everything lives in fixed arrays, nothing allocates while
+// playing, and a disabled profiler costs a branch per scope.
+class FrameProfiler {
+public:
+    static constexpr size_t HISTORY = 240;
+    static constexpr size_t PHASES = (size_t)ProfilePhase::Count;
+    using Clock = std::chrono::steady_clock;
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return m_enabled; }
+
+    // call once per frame, before anything is timed. The frame time is the
+    // time since the previous call
+    void NextFrame();
+    void AddTime(ProfilePhase phase, double seconds) { m_current[(size_t)phase] += seconds; }
+
+    // over the recorded history, in milliseconds
+    double GetPhaseAverageMs(ProfilePhase phase) const;
+    double GetFramePercentileMs(double percentile) const;
+    size_t GetFrameCount() const { return m_count; }
+    // i = 0 is the oldest recorded frame
+    double GetFrameMs(size_t i) const;
+
+private:
+    bool m_enabled = false;
+    bool m_started = false;
+    Clock::time_point m_frameStart;
+    std::array<double, PHASES> m_current{};
+    std::array<std::array<double, PHASES>, HISTORY> m_phases{};
+    std::array<double, HISTORY> m_frames{};
+    size_t m_next = 0;  // ring write position
+    size_t m_count = 0; // frames recorded, up to HISTORY
+};
+
+// Adds the time until the end of the enclosing scope to a phase. A null or
+// disabled profiler skips reading the clock.
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler* profiler, ProfilePhase phase)
+    : m_profiler(profiler && profiler->IsEnabled() ? profiler : nullptr), m_phase(phase) {
+        if (m_profiler) m_start = FrameProfiler::Clock::now();
+    }
+    ~ProfileScope() {
+        if (m_profiler) {
+            m_profiler->AddTime(m_phase, std::chrono::duration<double>(FrameProfiler::Clock::now() - m_start).count());
+        }
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler* m_profiler;
+    ProfilePhase m_phase;
+    FrameProfiler::Clock::time_point m_start;
+};
@@ -0,0 +1,72 @@
+#include "InputLog.h"
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+    // bump when the layout changes
+    constexpr uint32_t LOG_VERSION = 1;
+    constexpr char LOG_MAGIC[4] = {'A', 'Q', 'I', 'N'};
+    constexpr size_t EVENT_BYTES = 6;
+
+    template <typename T>
+    void WriteValue(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool ReadValue(std::ifstream& file, T& value) {
+        return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+}
+
+bool InputLog::Save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+    WriteValue(file, LOG_VERSION);
+    WriteValue(file, seed);
+    WriteValue(file, tickRate);
+    WriteValue(file, width);
+    WriteValue(file, height);
+    WriteValue(file, tickCount);
+    WriteValue(file, (uint32_t)events.size());
+
+    std::vector<char> packed(events.size() * EVENT_BYTES);
+    for (size_t i = 0; i < events.size(); ++i) {
+        char* out = &packed[i * EVENT_BYTES];
+        std::memcpy(out, &events[i].tick, sizeof(uint32_t));
+        out[4] = (char)events[i].key;
+        out[5] = events[i].pressed ? 1 : 0;
+    }
+    file.write(packed.data(), packed.size());
+    return (bool)file;
+}
+
+bool InputLog::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    char magic[4];
+    uint32_t version = 0;
+    InputLog log;
+    uint32_t eventCount = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0) return false;
+    if (!ReadValue(file, version) || version != LOG_VERSION) return false;
+    if (!ReadValue(file, log.seed) || !ReadValue(file, log.tickRate) || !ReadValue(file, log.width)
+        || !ReadValue(file, log.height) || !ReadValue(file, log.tickCount) || !ReadValue(file, eventCount)) {
+        return false;
+    }
+
+    std::vector<char> packed((size_t)eventCount * EVENT_BYTES);
+    if (eventCount > 0 && !file.read(packed.data(), packed.size())) return false;
+    log.events.resize(eventCount);
+    for (size_t i = 0; i < eventCount; ++i) {
+        const char* in = &packed[i * EVENT_BYTES];
+        std::memcpy(&log.events[i].tick, in, sizeof(uint32_t));
+        if ((uint8_t)in[4] >= (uint8_t)PlayerKey::Count) return false;
+        log.events[i].key = PlayerKey((uint8_t)in[4]);
+        log.events[i].pressed = in[5] != 0;
+    }
+    *this = std::move(log);
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The keys that steer the player. The app maps its arrow keys onto these,
+// the headless driver presses them itself.
+enum class PlayerKey : uint8_t {
+    Up,
+    Down,
+    Left,
+    Right,
+    Count
+};
+
+// a key going down or up before simulation tick `tick` ran
+struct InputEvent {
+    uint32_t tick;
+    PlayerKey key;
+    bool pressed;
+};
+
+// Everything needed to play a session again: the seed and world it ran
+// with, and every key event stamped with its tick. AquariumSimulation
+// records into one (SetRecorder) and plays one back (SetReplay).
+//
+// On disk: a small header, then 6 bytes per event (tick, key, pressed),
+// native byte order.
+struct InputLog {
+    uint64_t seed = 1;
+    float tickRate = 60.0f;
+    int32_t width = 0;
+    int32_t height = 0;
+    uint32_t tickCount = 0; // ticks the session ran, a replay stops there
+    std::vector<InputEvent> events;
+
+    bool Save(const std::string& path) const;
+    // false (and the log untouched) if the file is missing or not a log
+    bool Load(const std::string& path);
+};
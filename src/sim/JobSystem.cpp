@@ -0,0 +1,132 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+
+namespace {
+    thread_local int t_workerIndex = 0;
+}
+
+int JobSystem::CurrentWorkerIndex() { return t_workerIndex; }
+
+JobSystem::JobSystem(int workers) {
+    if (workers <= 0) {
+        workers = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < workers; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < workers; ++i) {
+        m_threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const RangeBody& body, size_t align) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    align = std::max<size_t>(align, 1);
+    int workers = GetWorkerCount();
+    if (workers == 1 || count <= grain) {
+        body(0, count);
+        return;
+    }
+
+    // a few chunks per worker so stealing can even out slow ones
+    size_t chunks = std::min((count + grain - 1) / grain, (size_t)workers * 4);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    chunkSize = (chunkSize + align - 1) / align * align;
+
+    chunks = (count + chunkSize - 1) / chunkSize;
+
+    std::lock_guard<std::mutex> run(m_runLock);
+    m_body = &body;
+    // set before the first push, a worker still draining the last call may
+    // grab a chunk the moment it is queued
+    m_pending = chunks;
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        // contiguous runs per worker, neighbours in memory stay on one core
+        Queue& queue = *m_queues[chunk * workers / chunks];
+        size_t begin = chunk * chunkSize;
+        std::lock_guard<std::mutex> lock(queue.lock);
+        queue.ranges.push_back(Range{begin, std::min(begin + chunkSize, count)});
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    while (runOne(0)) {}
+    std::unique_lock<std::mutex> lock(m_wakeLock);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_body = nullptr;
+}
+
+bool JobSystem::runOne(int index) {
+    Range range;
+    bool found = false;
+    int workers = GetWorkerCount();
+    for (int k = 0; k < workers && !found; ++k) {
+        Queue& queue = *m_queues[(index + k) % workers];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        if (queue.ranges.empty()) continue;
+        // own work from the front, stolen work from the back
+        if (k == 0) {
+            range = queue.ranges.front();
+            queue.ranges.pop_front();
+        } else {
+            range = queue.ranges.back();
+            queue.ranges.pop_back();
+        }
+        found = true;
+    }
+    if (!found) return false;
+
+    (*m_body)(range.begin, range.end);
+    if (--m_pending == 0) {
+        std::lock_guard<std::mutex> lock(m_wakeLock); // so the wait can't miss it
+        m_done.notify_all();
+    }
+    return true;
+}
+
+void JobSystem::workerLoop(int index) {
+    t_workerIndex = index;
+    unsigned seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeLock);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+        while (runOne(index)) {}
+    }
+}
+
+
+namespace {
+    int g_simWorkerCount = 0;
+    std::unique_ptr<JobSystem> g_simJobSystem;
+}
+
+void SetSimWorkerCount(int workers) { g_simWorkerCount = std::max(0, workers); }
+int GetSimWorkerCount() { return g_simWorkerCount; }
+
+JobSystem& SimJobSystem() {
+    int wanted = g_simWorkerCount > 0 ? g_simWorkerCount : std::max(1, (int)std::thread::hardware_concurrency());
+    if (!g_simJobSystem || g_simJobSystem->GetWorkerCount() != wanted) {
+        g_simJobSystem = std::make_unique<JobSystem>(wanted);
+    }
+    return *g_simJobSystem;
+}
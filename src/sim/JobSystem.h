@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool for splitting a loop over creatures across
+// cores. ParallelFor cuts [0, count) into chunks and deals them out to one
+// queue per worker, each worker drains its own queue and then steals from
+// the others, the calling thread works too. Chunk boundaries only depend on
+// count, grain and the worker count, never on timing, so as long as the body
+// only writes to its own range the result is the same on every run.
+class JobSystem {
+public:
+    using RangeBody = std::function<void(size_t begin, size_t end)>;
+
+    // workers includes the calling thread, 0 means one per hardware thread
+    explicit JobSystem(int workers = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int GetWorkerCount() const { return (int)m_queues.size(); }
+    // index of the pool worker running the caller, 0 on any thread that
+    // isn't a pool worker (the calling thread counts as worker 0)
+    static int CurrentWorkerIndex();
+
+    // runs body over [0, count) in chunks of at least grain items and returns
+    // when all of them are done. Chunk starts are multiples of align so SIMD
+    // loops inside the body see whole blocks. Small loops just run inline.
+    void ParallelFor(size_t count, size_t grain, const RangeBody& body, size_t align = 8);
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+    struct Queue {
+        std::mutex lock;
+        std::deque<Range> ranges;
+    };
+
+    void workerLoop(int index);
+    bool runOne(int index); // own queue first, then steal, false when all are empty
+
+    std::vector<std::unique_ptr<Queue>> m_queues; // [0] belongs to the calling thread
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_runLock; // one ParallelFor at a time
+    std::mutex m_wakeLock;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    unsigned m_generation = 0;
+    bool m_stop = false;
+    const RangeBody* m_body = nullptr;
+    std::atomic<size_t> m_pending{0};
+};
+
+// Worker count for the simulation's shared pool, 0 (default) is one per
+// hardware thread and 1 keeps everything on the calling thread. Takes effect
+// the next time SimJobSystem() is asked for the pool.
+void SetSimWorkerCount(int workers);
+int GetSimWorkerCount();
+
+// the pool Aquarium::update uses, created on first use
+JobSystem& SimJobSystem();
@@ -0,0 +1,513 @@
+#include "LevelData.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "AquariumSim.h"
+
+
+namespace {
+
+// bump when the record layout changes, old caches are then rebuilt
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr char CACHE_MAGIC[4] = {'A', 'Q', 'L', 'V'};
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    int32_t playerSpeed;
+    uint32_t levelCount;
+    uint32_t populationCount;
+    uint32_t waveCount;
+    uint32_t spawnCount;
+    uint32_t stringBytes;
+};
+
+// names used in the XML, the enum spelled out
+const char* const CREATURE_TYPE_NAMES[] = {
+    "Player", "NPCreature", "BiggerFish", "PowerUp", "SpeedFruit", "GyaradosFish", "AnglerFish", "Omanyte"
+};
+
+// what a level can populate or spawn: every creature but the player
+bool IsSpawnableType(int type) {
+    return type > (int)AquariumCreatureType::Player && (size_t)type < std::size(CREATURE_TYPE_NAMES);
+}
+
+bool CreatureTypeFromName(const std::string& name, int& type) {
+    for (size_t i = 0; i < std::size(CREATURE_TYPE_NAMES); ++i) {
+        if (name == CREATURE_TYPE_NAMES[i]) {
+            type = (int)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t HashBytes(const std::string& bytes) {
+    uint64_t hash = 1469598103934665603ull; // FNV-1a
+    for (unsigned char c : bytes) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool ReadWholeFile(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+// Just enough XML for the settings file: elements, attributes, text,
+// comments and the <?xml?> prolog. No DTDs, CDATA or namespaces.
+struct XmlElement {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> attributes;
+    std::string text;
+    std::vector<XmlElement> children;
+
+    const std::string* attribute(const char* key) const {
+        for (const auto& attribute : attributes) {
+            if (attribute.first == key) return &attribute.second;
+        }
+        return nullptr;
+    }
+};
+
+class XmlReader {
+public:
+    explicit XmlReader(const std::string& text) : m_text(text) {}
+
+    bool readDocument(XmlElement& root, std::string& error) {
+        skipMisc();
+        if (!readElement(root)) {
+            error = m_error;
+            return false;
+        }
+        skipMisc();
+        if (m_pos != m_text.size()) {
+            fail("content after the root element");
+            error = m_error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool startsWith(const char* s) const { return m_text.compare(m_pos, std::strlen(s), s) == 0; }
+    bool atEnd() const { return m_pos >= m_text.size(); }
+
+    bool fail(const std::string& message) {
+        int line = 1 + (int)std::count(m_text.begin(), m_text.begin() + std::min(m_pos, m_text.size()), '\n');
+        m_error = "line " + std::to_string(line) + ": " + message;
+        return false;
+    }
+
+    void skipSpace() {
+        while (!atEnd() && std::isspace((unsigned char)m_text[m_pos])) ++m_pos;
+    }
+
+    // whitespace, comments and processing instructions between elements
+    void skipMisc() {
+        for (;;) {
+            skipSpace();
+            const char* close = startsWith("<!--") ? "-->" : startsWith("<?") ? "?>" : nullptr;
+            if (!close) return;
+            size_t end = m_text.find(close, m_pos);
+            m_pos = end == std::string::npos ? m_text.size() : end + std::strlen(close);
+        }
+    }
+
+    bool readName(std::string& name) {
+        size_t start = m_pos;
+        while (!atEnd() && (std::isalnum((unsigned char)m_text[m_pos]) || std::strchr("_-.:", m_text[m_pos]))) ++m_pos;
+        if (m_pos == start) return fail("expected a name");
+        name.assign(m_text, start, m_pos - start);
+        return true;
+    }
+
+    bool decode(size_t start, size_t end, std::string& out) {
+        out.clear();
+        for (size_t i = start; i < end; ++i) {
+            if (m_text[i] != '&') {
+                out += m_text[i];
+                continue;
+            }
+            static const std::pair<const char*, char> entities[] = {
+                {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}
+            };
+            bool known = false;
+            for (const auto& entity : entities) {
+                if (m_text.compare(i, std::strlen(entity.first), entity.first) == 0) {
+                    out += entity.second;
+                    i += std::strlen(entity.first) - 1;
+                    known = true;
+                    break;
+                }
+            }
+            if (!known) {
+                m_pos = i;
+                return fail("unknown entity");
+            }
+        }
+        return true;
+    }
+
+    bool readElement(XmlElement& element) {
+        if (!startsWith("<")) return fail("expected an element");
+        ++m_pos;
+        if (!readName(element.name)) return false;
+        for (;;) {
+            skipSpace();
+            if (startsWith("/>")) {
+                m_pos += 2;
+                return true;
+            }
+            if (startsWith(">")) {
+                ++m_pos;
+                break;
+            }
+            std::pair<std::string, std::string> attribute;
+            if (!readName(attribute.first)) return false;
+            skipSpace();
+            if (!startsWith("=")) return fail("expected '=' after " + attribute.first);
+            ++m_pos;
+            skipSpace();
+            char quote = atEnd() ? 0 : m_text[m_pos];
+            if (quote != '"' && quote != '\'') return fail("expected a quoted value for " + attribute.first);
+            size_t end = m_text.find(quote, m_pos + 1);
+            if (end == std::string::npos) return fail("unterminated value for " + attribute.first);
+            if (!decode(m_pos + 1, end, attribute.second)) return false;
+            m_pos = end + 1;
+            element.attributes.push_back(std::move(attribute));
+        }
+        // content: text and child elements until the matching end tag
+        std::string text;
+        for (;;) {
+            size_t start = m_pos;
+            while (!atEnd() && m_text[m_pos] != '<') ++m_pos;
+            if (atEnd()) return fail("missing </" + element.name + ">");
+            std::string piece;
+            if (!decode(start, m_pos, piece)) return false;
+            text += piece;
+            if (startsWith("</")) {
+                m_pos += 2;
+                std::string name;
+                if (!readName(name)) return false;
+                if (name != element.name) return fail("</" + name + "> closes <" + element.name + ">");
+                skipSpace();
+                if (!startsWith(">")) return fail("expected '>'");
+                ++m_pos;
+                break;
+            }
+            if (startsWith("<!--") || startsWith("<?")) {
+                skipMisc();
+                continue;
+            }
+            element.children.emplace_back();
+            if (!readElement(element.children.back())) return false;
+        }
+        size_t first = text.find_first_not_of(" \t\r\n");
+        size_t last = text.find_last_not_of(" \t\r\n");
+        element.text = first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+        return true;
+    }
+
+    const std::string& m_text;
+    size_t m_pos = 0;
+    std::string m_error;
+};
+
+bool ParseInt(const std::string& text, int& out) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') return false;
+    out = (int)value;
+    return true;
+}
+
+bool ParseFloat(const std::string& text, float& out) {
+    char* end = nullptr;
+    float value = std::strtof(text.c_str(), &end);
+    if (text.empty() || *end != '\0') return false;
+    out = value;
+    return true;
+}
+
+// <population type="..." count="..."/> and <spawn .../> share their attributes
+bool ReadCreatureCount(const XmlElement& element, int& type, int& count, std::string& error) {
+    const std::string* typeName = element.attribute("type");
+    const std::string* countText = element.attribute("count");
+    if (!typeName || !CreatureTypeFromName(*typeName, type)) {
+        error = "<" + element.name + "> needs a creature type, got '" + (typeName ? *typeName : "") + "'";
+        return false;
+    }
+    if (!IsSpawnableType(type)) {
+        error = "<" + element.name + "> can't place a " + *typeName;
+        return false;
+    }
+    count = 1;
+    if (countText && (!ParseInt(*countText, count) || count < 0)) {
+        error = "<" + element.name + "> count '" + *countText + "' is not a count";
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool ReadArray(std::ifstream& file, std::vector<T>& out, uint32_t count) {
+    out.resize(count);
+    return count == 0 || (bool)file.read(reinterpret_cast<char*>(out.data()), sizeof(T) * count);
+}
+
+template <typename T>
+void WriteArray(std::ofstream& file, const std::vector<T>& values) {
+    if (!values.empty()) file.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+}
+
+} // namespace
+
+
+void LevelTable::beginLevel(int targetScore, float waveSeconds, const std::string& description) {
+    LevelRecord level;
+    level.number = (int32_t)levels.size() + 1;
+    level.targetScore = targetScore;
+    level.waveSeconds = waveSeconds;
+    level.firstPopulation = (uint32_t)populations.size();
+    level.populationCount = 0;
+    level.firstWave = (uint32_t)waves.size();
+    level.waveCount = 0;
+    level.descriptionOffset = (uint32_t)strings.size();
+    level.descriptionLength = (uint32_t)description.size();
+    strings += description;
+    levels.push_back(level);
+}
+
+void LevelTable::addPopulation(int type, int count) {
+    populations.push_back(CreatureCountRecord{type, count});
+    ++levels.back().populationCount;
+}
+
+void LevelTable::beginWave() {
+    waves.push_back(WaveRecord{(uint32_t)spawns.size(), 0});
+    ++levels.back().waveCount;
+}
+
+void LevelTable::addSpawn(int type, int count) {
+    spawns.push_back(CreatureCountRecord{type, count});
+    ++waves.back().spawnCount;
+}
+
+std::string LevelTable::getDescription(const LevelRecord& level) const {
+    return strings.substr(level.descriptionOffset, level.descriptionLength);
+}
+
+bool LevelTable::isValid() const {
+    for (const LevelRecord& level : levels) {
+        if (level.targetScore <= 0 || !(level.waveSeconds > 0.0f)) return false;
+        if ((size_t)level.firstPopulation + level.populationCount > populations.size()) return false;
+        if ((size_t)level.firstWave + level.waveCount > waves.size()) return false;
+        if ((size_t)level.descriptionOffset + level.descriptionLength > strings.size()) return false;
+    }
+    for (const WaveRecord& wave : waves) {
+        if ((size_t)wave.firstSpawn + wave.spawnCount > spawns.size()) return false;
+    }
+    for (const std::vector<CreatureCountRecord>* records : {&populations, &spawns}) {
+        for (const CreatureCountRecord& record : *records) {
+            if (!IsSpawnableType(record.type) || record.count < 0) return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const LevelTable> StockLevelTable() {
+    static const std::shared_ptr<const LevelTable> stock = [] {
+        const int NPC = (int)AquariumCreatureType::NPCreature;
+        const int BIG = (int)AquariumCreatureType::BiggerFish;
+        const int GYARADOS = (int)AquariumCreatureType::GyaradosFish;
+        const int ANGLER = (int)AquariumCreatureType::AnglerFish;
+        auto table = std::make_shared<LevelTable>();
+
+        table->beginLevel(30, 2.0f, "Nivel 1: Ecosistema Basico - Peces Dorados Pacificos");
+        table->addPopulation(NPC, 14);
+        table->addPopulation(ANGLER, 4);
+        table->beginWave(); table->addSpawn(NPC, 4);
+        table->beginWave(); table->addSpawn(NPC, 6);
+        table->beginWave(); table->addSpawn(NPC, 4); table->addSpawn(ANGLER, 1);
+
+        table->beginLevel(80, 2.0f, "Nivel 2: Arrecife de Coral - Aparecen Gyarados!");
+        table->addPopulation(NPC, 9);
+        table->addPopulation(BIG, 5);
+        table->addPopulation(ANGLER, 3);
+        table->beginWave(); table->addSpawn(NPC, 4); table->addSpawn(BIG, 1);
+        table->beginWave(); table->addSpawn(NPC, 3); table->addSpawn(BIG, 2);
+        table->beginWave(); table->addSpawn(NPC, 5); table->addSpawn(BIG, 2); table->addSpawn(GYARADOS, 1);
+        table->beginWave(); table->addSpawn(BIG, 2); table->addSpawn(GYARADOS, 2);
+
+        table->beginLevel(150, 2.0f, "Nivel 3: Oceano Profundo - Peligros y Maravillas!");
+        table->addPopulation(NPC, 6);
+        table->addPopulation(BIG, 8);
+        table->addPopulation(GYARADOS, 6);
+        table->addPopulation(ANGLER, 6);
+        table->beginWave(); table->addSpawn(NPC, 3); table->addSpawn(BIG, 1); table->addSpawn(ANGLER, 1);
+        table->beginWave(); table->addSpawn(NPC, 2); table->addSpawn(BIG, 2); table->addSpawn(GYARADOS, 1);
+        table->beginWave(); table->addSpawn(NPC, 1); table->addSpawn(BIG, 2); table->addSpawn(ANGLER, 2);
+        table->beginWave(); table->addSpawn(BIG, 2); table->addSpawn(GYARADOS, 2); table->addSpawn(ANGLER, 2);
+        table->beginWave(); table->addSpawn(GYARADOS, 3); table->addSpawn(ANGLER, 3);
+        return table;
+    }();
+    return stock;
+}
+
+// <group>
+//     <player_speed>5</player_speed>
+//     <levels>
+//         <level target="30" wave_seconds="2" description="...">
+//             <population type="NPCreature" count="14"/>
+//             <wave><spawn type="NPCreature" count="4"/></wave>
+//         </level>
+//     </levels>
+// </group>
+// Unknown elements are ignored, levels are numbered in file order.
+bool ParseLevelTableXml(const std::string& text, LevelTable& out, std::string& error) {
+    XmlElement root;
+    if (!XmlReader(text).readDocument(root, error)) return false;
+
+    out = LevelTable();
+    for (const XmlElement& setting : root.children) {
+        if (setting.name == "player_speed" && !ParseInt(setting.text, out.playerSpeed)) {
+            error = "player_speed '" + setting.text + "' is not a number";
+            return false;
+        }
+        if (setting.name != "levels") continue;
+        for (const XmlElement& level : setting.children) {
+            if (level.name != "level") continue;
+            int target = 0;
+            float waveSeconds = 2.0f;
+            const std::string* targetText = level.attribute("target");
+            const std::string* secondsText = level.attribute("wave_seconds");
+            const std::string* description = level.attribute("description");
+            const std::string levelName = "level " + std::to_string(out.levels.size() + 1);
+            if (!targetText || !ParseInt(*targetText, target)) {
+                error = levelName + " needs a numeric target";
+                return false;
+            }
+            if (target <= 0) {
+                error = levelName + " target " + *targetText + " has to be above 0";
+                return false;
+            }
+            if (secondsText && !ParseFloat(*secondsText, waveSeconds)) {
+                error = levelName + " wave_seconds '" + *secondsText + "' is not a number";
+                return false;
+            }
+            // a zero wave timer would fire every step (and NaN never)
+            if (!(waveSeconds > 0.0f)) {
+                error = levelName + " wave_seconds " + *secondsText + " has to be above 0";
+                return false;
+            }
+            out.beginLevel(target, waveSeconds, description ? *description : std::string());
+
+            int type = 0;
+            int count = 0;
+            for (const XmlElement& child : level.children) {
+                if (child.name == "population") {
+                    if (!ReadCreatureCount(child, type, count, error)) {
+                        error = levelName + ": " + error;
+                        return false;
+                    }
+                    out.addPopulation(type, count);
+                } else if (child.name == "wave") {
+                    out.beginWave();
+                    for (const XmlElement& spawn : child.children) {
+                        if (spawn.name != "spawn") continue;
+                        if (!ReadCreatureCount(spawn, type, count, error)) {
+                            error = levelName + ": " + error;
+                            return false;
+                        }
+                        out.addSpawn(type, count);
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool WriteLevelTableCache(const std::string& path, const LevelTable& table, uint64_t sourceHash) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.playerSpeed = table.playerSpeed;
+    header.levelCount = (uint32_t)table.levels.size();
+    header.populationCount = (uint32_t)table.populations.size();
+    header.waveCount = (uint32_t)table.waves.size();
+    header.spawnCount = (uint32_t)table.spawns.size();
+    header.stringBytes = (uint32_t)table.strings.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteArray(file, table.levels);
+    WriteArray(file, table.populations);
+    WriteArray(file, table.waves);
+    WriteArray(file, table.spawns);
+    file.write(table.strings.data(), table.strings.size());
+    return (bool)file;
+}
+
+bool ReadLevelTableCache(const std::string& path, LevelTable& out, uint64_t& sourceHash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_VERSION) return false;
+
+    LevelTable table;
+    table.playerSpeed = header.playerSpeed;
+    table.strings.resize(header.stringBytes);
+    if (!ReadArray(file, table.levels, header.levelCount)
+        || !ReadArray(file, table.populations, header.populationCount)
+        || !ReadArray(file, table.waves, header.waveCount)
+        || !ReadArray(file, table.spawns, header.spawnCount)
+        || (header.stringBytes > 0 && !file.read(&table.strings[0], header.stringBytes))
+        || !table.isValid()) {
+        return false;
+    }
+    out = std::move(table);
+    sourceHash = header.sourceHash;
+    return true;
+}
+
+std::shared_ptr<const LevelTable> LoadLevelTable(const std::string& xmlPath, const std::string& cachePath) {
+    auto table = std::make_shared<LevelTable>();
+    uint64_t cachedHash = 0;
+    std::string text;
+    if (!ReadWholeFile(xmlPath, text)) {
+        if (ReadLevelTableCache(cachePath, *table, cachedHash)) {
+            return table;
+        }
+        SIM_LOG_WARNING() << "no level data in " << xmlPath << " or " << cachePath << ", using the stock levels";
+        return StockLevelTable();
+    }
+
+    uint64_t hash = HashBytes(text);
+    if (ReadLevelTableCache(cachePath, *table, cachedHash) && cachedHash == hash) {
+        return table;
+    }
+    std::string error;
+    if (!ParseLevelTableXml(text, *table, error)) {
+        SIM_LOG_ERROR() << xmlPath << ": " << error << ", using the stock levels";
+        return StockLevelTable();
+    }
+    if (table->levels.empty()) {
+        SIM_LOG_WARNING() << xmlPath << " has no levels, using the stock levels";
+        return StockLevelTable();
+    }
+    if (!WriteLevelTableCache(cachePath, *table, hash)) {
+        SIM_LOG_WARNING() << "couldn't write the level cache " << cachePath;
+    }
+    SIM_LOG_NOTICE() << "compiled " << xmlPath << " into " << cachePath;
+    return table;
+}
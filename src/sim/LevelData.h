@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Level, population and wave tables for the aquarium. They are written in
+// bin/data/settings.xml and compiled on first load into a flat binary cache
+// (settings.bin) that later runs read straight into these arrays, the XML
+// is only parsed again when its contents change.
+//
+// Everything is flat records indexing into shared arrays, so a table is a
+// handful of vectors and the cache is those vectors written back to back.
+// Creature types are stored as AquariumCreatureType values.
+
+struct CreatureCountRecord {
+    int32_t type;
+    int32_t count;
+};
+
+struct WaveRecord {
+    uint32_t firstSpawn; // into LevelTable::spawns
+    uint32_t spawnCount;
+};
+
+struct LevelRecord {
+    int32_t number;
+    int32_t targetScore;
+    float waveSeconds;
+    uint32_t firstPopulation; // into LevelTable::populations
+    uint32_t populationCount;
+    uint32_t firstWave;       // into LevelTable::waves
+    uint32_t waveCount;
+    uint32_t descriptionOffset; // into LevelTable::strings
+    uint32_t descriptionLength;
+};
+
+struct LevelTable {
+    int32_t playerSpeed = 5;
+    std::vector<LevelRecord> levels;
+    std::vector<CreatureCountRecord> populations;
+    std::vector<WaveRecord> waves;
+    std::vector<CreatureCountRecord> spawns;
+    std::string strings;
+
+    // building, in file order: a level, then its populations and waves,
+    // each wave followed by its spawns
+    void beginLevel(int targetScore, float waveSeconds, const std::string& description);
+    void addPopulation(int type, int count);
+    void beginWave();
+    void addSpawn(int type, int count);
+
+    std::string getDescription(const LevelRecord& level) const;
+    // false if any range points outside the arrays
+    bool isValid() const;
+};
+
+// the three levels the game shipped with, used when there is no data file
+std::shared_ptr<const LevelTable> StockLevelTable();
+
+// XML text to table, false with a message on the first error
+bool ParseLevelTableXml(const std::string& text, LevelTable& out, std::string& error);
+
+// sourceHash identifies the XML the table was compiled from
+bool WriteLevelTableCache(const std::string& path, const LevelTable& table, uint64_t sourceHash);
+bool ReadLevelTableCache(const std::string& path, LevelTable& out, uint64_t& sourceHash);
+
+// Loads xmlPath through the cache at cachePath, rebuilding the cache when it
+// is missing, stale or from another version. Without the XML a cache alone
+// is used as is; with neither, or on a parse error, this logs and returns
+// the stock table.
+std::shared_ptr<const LevelTable> LoadLevelTable(const std::string& xmlPath, const std::string& cachePath);
@@ -0,0 +1,251 @@
+#include "MotionKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AQUARIUM_X86 1
+#include <immintrin.h>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc/clang only emit AVX2 inside functions that ask for it, msvc always can
+#if defined(AQUARIUM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AQUARIUM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define AQUARIUM_TARGET_AVX2
+#endif
+
+namespace {
+
+const unsigned char kPassive = (unsigned char)CreatureMotion::Passive;
+
+void integrateScalar(CreatureStore& store, size_t begin, size_t end) {
+    const unsigned char* motion = reinterpret_cast<const unsigned char*>(store.motion.data());
+    float* xs = store.x.data();
+    float* ys = store.y.data();
+    float* dxs = store.dx.data();
+    float* dys = store.dy.data();
+    const float* steps = store.step.data();
+    const float* radii = store.radius.data();
+    const float* boundW = store.boundW.data();
+    const float* boundH = store.boundH.data();
+    unsigned char* flipped = store.flipped.data();
+    for (size_t i = begin; i < end; ++i) {
+        if (motion[i] != kPassive) continue;
+        float r = radii[i];
+        float dx = dxs[i];
+        float dy = dys[i];
+        float x = xs[i] + dx * steps[i];
+        float y = ys[i] + dy * steps[i];
+        flipped[i] = dx < 0;
+        if (x < r) {
+            x = r;
+            dx = -dx;
+        } else if (x > boundW[i] - r) {
+            x = boundW[i] - r;
+            dx = -dx;
+        }
+        if (y < r) {
+            y = r;
+            dy = -dy;
+        } else if (y > boundH[i] - r) {
+            y = boundH[i] - r;
+            dy = -dy;
+        }
+        xs[i] = x;
+        ys[i] = y;
+        dxs[i] = dx;
+        dys[i] = dy;
+    }
+}
+
+#ifdef AQUARIUM_X86
+
+// byte k of the result is bit k of bits (0 or 1), for up to 8 lanes
+inline unsigned long long spreadBits(int bits) {
+    unsigned long long x = (unsigned long long)(bits & 0xFF) * 0x0101010101010101ULL;
+    x &= 0x8040201008040201ULL;
+    return ((x + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+}
+
+// passive lanes take their facing from dx < 0, the rest keep theirs.
+// One unaligned word read/write instead of a byte loop.
+inline void writeFlipped(unsigned char* flipped, int passiveBits, int leftBits, int lanes) {
+    unsigned long long keep = spreadBits(~passiveBits) * 0xFF;
+    unsigned long long left = spreadBits(leftBits & passiveBits);
+    unsigned long long word = 0;
+    std::memcpy(&word, flipped, lanes);
+    word = (word & keep) | left;
+    std::memcpy(flipped, &word, lanes);
+}
+
+// one axis: pos + vel * step, then reflect off [r, bound - r]. Below wins
+// when both walls are hit, like the if/else in the scalar loop.
+inline void reflectSSE(__m128& pos, __m128& vel, __m128 r, __m128 bound, __m128 passive) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 hi = _mm_sub_ps(bound, r);
+    __m128 below = _mm_cmplt_ps(pos, r);
+    __m128 above = _mm_andnot_ps(below, _mm_cmpgt_ps(pos, hi));
+    pos = _mm_or_ps(_mm_andnot_ps(_mm_or_ps(below, above), pos),
+                    _mm_or_ps(_mm_and_ps(below, r), _mm_and_ps(above, hi)));
+    vel = _mm_xor_ps(vel, _mm_and_ps(_mm_and_ps(_mm_or_ps(below, above), passive), sign));
+}
+
+void integrateSSE2(CreatureStore& store, size_t begin, size_t end) {
+    const unsigned char* motion = reinterpret_cast<const unsigned char*>(store.motion.data());
+    float* xs = store.x.data();
+    float* ys = store.y.data();
+    float* dxs = store.dx.data();
+    float* dys = store.dy.data();
+    const float* steps = store.step.data();
+    const float* radii = store.radius.data();
+    const float* boundW = store.boundW.data();
+    const float* boundH = store.boundH.data();
+    unsigned char* flipped = store.flipped.data();
+    const __m128i passiveCode = _mm_set1_epi32(kPassive);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        int packed;
+        std::memcpy(&packed, motion + i, 4);
+        __m128i codes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        __m128 passive = _mm_castsi128_ps(_mm_cmpeq_epi32(codes, passiveCode));
+        int passiveBits = _mm_movemask_ps(passive);
+        if (passiveBits == 0) continue;
+
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+        __m128 dx = _mm_loadu_ps(dxs + i);
+        __m128 dy = _mm_loadu_ps(dys + i);
+        __m128 step = _mm_loadu_ps(steps + i);
+        __m128 r = _mm_loadu_ps(radii + i);
+
+        int leftBits = _mm_movemask_ps(_mm_cmplt_ps(dx, _mm_setzero_ps()));
+        __m128 nx = _mm_add_ps(x, _mm_mul_ps(dx, step));
+        __m128 ny = _mm_add_ps(y, _mm_mul_ps(dy, step));
+        reflectSSE(nx, dx, r, _mm_loadu_ps(boundW + i), passive);
+        reflectSSE(ny, dy, r, _mm_loadu_ps(boundH + i), passive);
+
+        _mm_storeu_ps(xs + i, _mm_or_ps(_mm_and_ps(passive, nx), _mm_andnot_ps(passive, x)));
+        _mm_storeu_ps(ys + i, _mm_or_ps(_mm_and_ps(passive, ny), _mm_andnot_ps(passive, y)));
+        _mm_storeu_ps(dxs + i, dx);
+        _mm_storeu_ps(dys + i, dy);
+        writeFlipped(flipped + i, passiveBits, leftBits, 4);
+    }
+    integrateScalar(store, i, end);
+}
+
+AQUARIUM_TARGET_AVX2
+inline void reflectAVX2(__m256& pos, __m256& vel, __m256 r, __m256 bound, __m256 passive) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 hi = _mm256_sub_ps(bound, r);
+    __m256 below = _mm256_cmp_ps(pos, r, _CMP_LT_OQ);
+    __m256 above = _mm256_andnot_ps(below, _mm256_cmp_ps(pos, hi, _CMP_GT_OQ));
+    pos = _mm256_blendv_ps(pos, hi, above);
+    pos = _mm256_blendv_ps(pos, r, below);
+    vel = _mm256_xor_ps(vel, _mm256_and_ps(_mm256_and_ps(_mm256_or_ps(below, above), passive), sign));
+}
+
+AQUARIUM_TARGET_AVX2
+void integrateAVX2(CreatureStore& store, size_t begin, size_t end) {
+    const unsigned char* motion = reinterpret_cast<const unsigned char*>(store.motion.data());
+    float* xs = store.x.data();
+    float* ys = store.y.data();
+    float* dxs = store.dx.data();
+    float* dys = store.dy.data();
+    const float* steps = store.step.data();
+    const float* radii = store.radius.data();
+    const float* boundW = store.boundW.data();
+    const float* boundH = store.boundH.data();
+    unsigned char* flipped = store.flipped.data();
+    const __m256i passiveCode = _mm256_set1_epi32(kPassive);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i codes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(motion + i)));
+        __m256 passive = _mm256_castsi256_ps(_mm256_cmpeq_epi32(codes, passiveCode));
+        int passiveBits = _mm256_movemask_ps(passive);
+        if (passiveBits == 0) continue;
+
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        __m256 dx = _mm256_loadu_ps(dxs + i);
+        __m256 dy = _mm256_loadu_ps(dys + i);
+        __m256 step = _mm256_loadu_ps(steps + i);
+        __m256 r = _mm256_loadu_ps(radii + i);
+
+        int leftBits = _mm256_movemask_ps(_mm256_cmp_ps(dx, _mm256_setzero_ps(), _CMP_LT_OQ));
+        // mul then add, not fma, so the result matches the scalar loop bit for bit
+        __m256 nx = _mm256_add_ps(x, _mm256_mul_ps(dx, step));
+        __m256 ny = _mm256_add_ps(y, _mm256_mul_ps(dy, step));
+        reflectAVX2(nx, dx, r, _mm256_loadu_ps(boundW + i), passive);
+        reflectAVX2(ny, dy, r, _mm256_loadu_ps(boundH + i), passive);
+
+        _mm256_storeu_ps(xs + i, _mm256_blendv_ps(x, nx, passive));
+        _mm256_storeu_ps(ys + i, _mm256_blendv_ps(y, ny, passive));
+        _mm256_storeu_ps(dxs + i, dx);
+        _mm256_storeu_ps(dys + i, dy);
+        writeFlipped(flipped + i, passiveBits, leftBits, 8);
+    }
+    integrateScalar(store, i, end);
+}
+
+bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false; // os saves ymm registers
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+MotionKernel detectMotionKernel() {
+#ifdef AQUARIUM_X86
+    if (cpuHasAVX2()) return MotionKernel::AVX2;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return MotionKernel::SSE2;
+#endif
+#endif
+    return MotionKernel::Scalar;
+}
+
+}
+
+MotionKernel BestMotionKernel() {
+    static const MotionKernel best = detectMotionKernel();
+    return best;
+}
+
+const char* MotionKernelToString(MotionKernel kernel) {
+    switch (kernel) {
+        case MotionKernel::Scalar: return "scalar";
+        case MotionKernel::SSE2: return "sse2";
+        case MotionKernel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+void IntegratePassive(CreatureStore& store, size_t begin, size_t end, MotionKernel kernel) {
+    if ((int)kernel > (int)BestMotionKernel()) kernel = BestMotionKernel();
+    if (end > store.size()) end = store.size();
+    if (begin >= end) return;
+    switch (kernel) {
+#ifdef AQUARIUM_X86
+        case MotionKernel::AVX2: integrateAVX2(store, begin, end); return;
+        case MotionKernel::SSE2: integrateSSE2(store, begin, end); return;
+#endif
+        default: integrateScalar(store, begin, end); return;
+    }
+}
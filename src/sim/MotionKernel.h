@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CreatureStore.h"
+
+// Bulk movement for CreatureMotion::Passive creatures: x += dx * step, face
+// the way dx points, then reflect off the [radius, bound - radius] walls.
+// Same math as Creature::bounce, the SIMD versions give the exact same
+// floats as the scalar one, so switching never changes a run.
+enum class MotionKernel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// fastest kernel this cpu can run, checked once
+MotionKernel BestMotionKernel();
+const char* MotionKernelToString(MotionKernel kernel);
+
+// moves the passive slots in [begin, end) and leaves every other slot as it
+// was. Asking for a kernel the cpu lacks falls back to BestMotionKernel()
+void IntegratePassive(CreatureStore& store, size_t begin, size_t end, MotionKernel kernel);
+
+inline void IntegratePassive(CreatureStore& store, MotionKernel kernel) {
+    IntegratePassive(store, 0, store.size(), kernel);
+}
@@ -0,0 +1,113 @@
+#include "Narrowphase.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AQUARIUM_X86 1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// same as MotionKernel.cpp: gcc/clang only emit AVX2 inside functions that ask for it
+#if defined(AQUARIUM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AQUARIUM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define AQUARIUM_TARGET_AVX2
+#endif
+
+namespace {
+
+uint64_t maskScalar(float x, float y, float r, const float* xs, const float* ys, const float* radii,
+                    size_t begin, size_t end) {
+    uint64_t mask = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (CirclesOverlap(x, y, r, xs[i], ys[i], radii[i])) mask |= uint64_t(1) << i;
+    }
+    return mask;
+}
+
+#ifdef AQUARIUM_X86
+
+uint64_t maskSSE2(float x, float y, float r, const float* xs, const float* ys, const float* radii, size_t count) {
+    const __m128 cx = _mm_set1_ps(x);
+    const __m128 cy = _mm_set1_ps(y);
+    const __m128 cr = _mm_set1_ps(r);
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), cy);
+        __m128 reach = _mm_add_ps(cr, _mm_loadu_ps(radii + i));
+        __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        mask |= uint64_t(_mm_movemask_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(reach, reach)))) << i;
+    }
+    return mask | maskScalar(x, y, r, xs, ys, radii, i, count);
+}
+
+AQUARIUM_TARGET_AVX2
+uint64_t maskAVX2(float x, float y, float r, const float* xs, const float* ys, const float* radii, size_t count) {
+    const __m256 cx = _mm256_set1_ps(x);
+    const __m256 cy = _mm256_set1_ps(y);
+    const __m256 cr = _mm256_set1_ps(r);
+    uint64_t mask = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), cy);
+        __m256 reach = _mm256_add_ps(cr, _mm256_loadu_ps(radii + i));
+        __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 hit = _mm256_cmp_ps(distSq, _mm256_mul_ps(reach, reach), _CMP_LT_OQ);
+        mask |= uint64_t(_mm256_movemask_ps(hit)) << i;
+    }
+    return mask | maskScalar(x, y, r, xs, ys, radii, i, count);
+}
+
+#endif
+
+inline int lowestBit(uint64_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+}
+
+uint64_t OverlapMask(float x, float y, float r, const float* xs, const float* ys, const float* radii,
+                     size_t count, MotionKernel kernel) {
+    if (count > 64) count = 64;
+    if ((int)kernel > (int)BestMotionKernel()) kernel = BestMotionKernel();
+    switch (kernel) {
+#ifdef AQUARIUM_X86
+        case MotionKernel::AVX2: return maskAVX2(x, y, r, xs, ys, radii, count);
+        case MotionKernel::SSE2: return maskSSE2(x, y, r, xs, ys, radii, count);
+#endif
+        default: return maskScalar(x, y, r, xs, ys, radii, 0, count);
+    }
+}
+
+// 64 candidates at a time, then walk the set bits. Short runs (the sweep's
+// usual case) go straight through the scalar test
+size_t OverlapIndices(float x, float y, float r, const float* xs, const float* ys, const float* radii,
+                      size_t count, std::vector<int>& hits, int begin, MotionKernel kernel) {
+    size_t before = hits.size();
+    if (count < 4) {
+        // too few for a vector, skip the mask
+        for (size_t i = 0; i < count; ++i) {
+            if (CirclesOverlap(x, y, r, xs[i], ys[i], radii[i])) hits.push_back(begin + (int)i);
+        }
+        return hits.size() - before;
+    }
+    for (size_t block = 0; block < count; block += 64) {
+        size_t lanes = count - block < 64 ? count - block : 64;
+        uint64_t mask = OverlapMask(x, y, r, xs + block, ys + block, radii + block, lanes, kernel);
+        while (mask != 0) {
+            hits.push_back(begin + (int)block + lowestBit(mask));
+            mask &= mask - 1;
+        }
+    }
+    return hits.size() - before;
+}
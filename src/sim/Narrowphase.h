@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MotionKernel.h"
+
+// Circle vs circle narrowphase, one circle against a run of candidates laid
+// out as plain arrays. Candidate i overlaps when
+//     (xs[i] - x)^2 + (ys[i] - y)^2 < (r + radii[i])^2
+// squared distances only, no sqrt. Every contact test in the simulation
+// (player pickups, NPC vs NPC, checkCollision) goes through here, so they
+// all agree on what touching means.
+//
+// The SIMD kernels are picked like the motion pass's (MotionKernel) and give
+// exactly the scalar result: same operations in the same order, no fma.
+
+// bit i set when candidate i overlaps, count is at most 64
+uint64_t OverlapMask(float x, float y, float r, const float* xs, const float* ys, const float* radii,
+                     size_t count, MotionKernel kernel = BestMotionKernel());
+
+// appends begin + i for every overlapping candidate i in [0, count), in
+// ascending order, and returns how many it appended
+size_t OverlapIndices(float x, float y, float r, const float* xs, const float* ys, const float* radii,
+                      size_t count, std::vector<int>& hits, int begin = 0, MotionKernel kernel = BestMotionKernel());
+
+// the single pair form of the same test
+inline bool CirclesOverlap(float ax, float ay, float ar, float bx, float by, float br) {
+    float dx = bx - ax;
+    float dy = by - ay;
+    float reach = ar + br;
+    return dx * dx + dy * dy < reach * reach;
+}
@@ -0,0 +1,131 @@
+#include "Schooling.h"
+#include <algorithm>
+#include <cmath>
+
+
+void SchoolOfFish::Steer(CreatureStore& store, AquariumCreatureType type, float width, float height, JobSystem& jobs) {
+    this->rebuild(store, type, width, height);
+    jobs.ParallelFor(m_slot.size(), STEER_CHUNK, [&](size_t begin, size_t end) {
+        this->steerRange(store, begin, end);
+    }, 1);
+}
+
+// counting sort of the schooling fish by cell: count, prefix sum, scatter
+void SchoolOfFish::rebuild(const CreatureStore& store, AquariumCreatureType type, float width, float height) {
+    float cellSize = std::max(m_params.neighborRadius, 1.0f);
+    m_invCellSize = 1.0f / cellSize;
+    m_cols = std::max(1, (int)std::ceil(width * m_invCellSize));
+    m_rows = std::max(1, (int)std::ceil(height * m_invCellSize));
+    m_cellStart.assign(m_cols * m_rows + 1, 0);
+
+    m_found.clear();
+    m_foundCell.clear();
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (store.type[i] != type) continue;
+        int cx = std::min(std::max((int)std::floor(store.x[i] * m_invCellSize), 0), m_cols - 1);
+        int cy = std::min(std::max((int)std::floor(store.y[i] * m_invCellSize), 0), m_rows - 1);
+        int cell = cy * m_cols + cx;
+        m_found.push_back((uint32_t)i);
+        m_foundCell.push_back(cell);
+        ++m_cellStart[cell + 1];
+    }
+    for (size_t c = 1; c < m_cellStart.size(); ++c) {
+        m_cellStart[c] += m_cellStart[c - 1];
+    }
+
+    size_t count = m_found.size();
+    m_slot.resize(count);
+    m_cell.resize(count);
+    m_x.resize(count);
+    m_y.resize(count);
+    m_dx.resize(count);
+    m_dy.resize(count);
+    // m_cellStart[c] doubles as the write cursor of cell c - 1, like SpatialGrid
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t slot = m_found[k];
+        int entry = m_cellStart[m_foundCell[k]]++;
+        m_slot[entry] = slot;
+        m_cell[entry] = m_foundCell[k];
+        m_x[entry] = store.x[slot];
+        m_y[entry] = store.y[slot];
+        m_dx[entry] = store.dx[slot];
+        m_dy[entry] = store.dy[slot];
+    }
+    for (size_t c = m_cellStart.size() - 1; c > 0; --c) {
+        m_cellStart[c] = m_cellStart[c - 1];
+    }
+    m_cellStart[0] = 0;
+}
+
+// Cells are sorted row major, so the three cells of one row around a fish
+// are one contiguous run of entries: three runs instead of nine cells. The
+// fish's own row goes first. A fish outside the radius (or the fish itself)
+// just weighs 0 instead of being branched around, and the scan stops as
+// soon as the neighbour cap is reached, so a packed cell costs about
+// maxNeighbors checks per fish rather than the whole cell.
+void SchoolOfFish::steerRange(CreatureStore& store, size_t begin, size_t end) const {
+    static const int rowOrder[3] = {0, -1, 1};
+    const SchoolingParams& p = m_params;
+    float neighborSq = p.neighborRadius * p.neighborRadius;
+    float separationSq = p.separationRadius * p.separationRadius;
+    float invNeighbor = 1.0f / std::max(p.neighborRadius, 1.0f);
+    float cap = (float)p.maxNeighbors;
+    const float* xs = m_x.data();
+    const float* ys = m_y.data();
+    const float* dxs = m_dx.data();
+    const float* dys = m_dy.data();
+
+    for (size_t k = begin; k < end; ++k) {
+        float x = xs[k];
+        float y = ys[k];
+        float dx = dxs[k];
+        float dy = dys[k];
+        int cx = m_cell[k] % m_cols;
+        int cy = m_cell[k] / m_cols;
+        int firstCol = std::max(cx - 1, 0);
+        int lastCol = std::min(cx + 1, m_cols - 1);
+
+        float neighbors = 0;
+        float sepX = 0, sepY = 0, headX = 0, headY = 0, sumX = 0, sumY = 0;
+        for (int r = 0; r < 3 && neighbors < cap; ++r) {
+            int row = cy + rowOrder[r];
+            if (row < 0 || row >= m_rows) continue;
+            int first = m_cellStart[row * m_cols + firstCol];
+            int last = m_cellStart[row * m_cols + lastCol + 1];
+            for (int j = first; j < last; ++j) {
+                float ox = xs[j] - x;
+                float oy = ys[j] - y;
+                float distSq = ox * ox + oy * oy;
+                // the fish itself sits at distance 0 and drops out here too
+                float near = (distSq <= neighborSq && distSq > 0.0f) ? 1.0f : 0.0f;
+                // inverse distance pointing away, for the ones that are too close
+                float push = (distSq < separationSq && distSq > 0.0f) ? 1.0f / std::sqrt(distSq) : 0.0f;
+                neighbors += near;
+                headX += near * dxs[j];
+                headY += near * dys[j];
+                sumX += near * ox;
+                sumY += near * oy;
+                sepX -= ox * push;
+                sepY -= oy * push;
+                if (neighbors >= cap) break;
+            }
+        }
+        if (neighbors == 0) continue; // a lone fish keeps swimming straight
+
+        float invCount = 1.0f / neighbors;
+        float steerX = p.separationWeight * sepX
+                     + p.alignmentWeight * (headX * invCount - dx)
+                     + p.cohesionWeight * sumX * invCount * invNeighbor;
+        float steerY = p.separationWeight * sepY
+                     + p.alignmentWeight * (headY * invCount - dy)
+                     + p.cohesionWeight * sumY * invCount * invNeighbor;
+        float newX = dx + steerX * p.turnRate;
+        float newY = dy + steerY * p.turnRate;
+        float length = std::sqrt(newX * newX + newY * newY);
+        if (length < 1e-6f) continue;
+
+        uint32_t slot = m_slot[k];
+        store.dx[slot] = newX / length;
+        store.dy[slot] = newY / length;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CreatureStore.h"
+#include "JobSystem.h"
+
+// Tuning for SchoolOfFish, distances in pixels.
+struct SchoolingParams {
+    float neighborRadius = 60.0f;   // fish further away than this are ignored
+    float separationRadius = 25.0f; // closer than this pushes apart
+    float separationWeight = 1.5f;
+    float alignmentWeight = 1.0f;
+    float cohesionWeight = 0.6f;
+    float turnRate = 0.1f; // share of the steering applied per tick
+    int maxNeighbors = 12; // a fish stops looking once it has seen this many
+};
+
+// Boids for the base fish: each fish turns away from the ones too close to
+// it, toward its neighbours' heading and toward their centre. Only the
+// heading (dx, dy) changes and stays unit length, the fish are still passive
+// and the motion kernel moves and bounces them afterwards.
+//
+// Neighbours come from a grid of its own rather than the aquarium's
+// SpatialGrid: it holds only the schooling fish, its cells are
+// neighborRadius wide so a fish never looks past the 3x3 cells around it,
+// and each entry carries the fish's position and heading so the inner loop
+// reads one sorted array instead of following indices into the store.
+// Steering reads those copies and writes the store, so fish are split across
+// the job system and the result is the same at any worker count.
+class SchoolOfFish {
+public:
+    void SetParams(const SchoolingParams& params) { m_params = params; }
+    const SchoolingParams& GetParams() const { return m_params; }
+
+    // steers every slot of the store whose type is `type`, over a
+    // width x height area
+    void Steer(CreatureStore& store, AquariumCreatureType type, float width, float height, JobSystem& jobs);
+
+    size_t GetFishCount() const { return m_slot.size(); }
+
+private:
+    // fish per job, the per fish work is a few dozen neighbour checks
+    static constexpr size_t STEER_CHUNK = 1024;
+
+    void rebuild(const CreatureStore& store, AquariumCreatureType type, float width, float height);
+    void steerRange(CreatureStore& store, size_t begin, size_t end) const;
+
+    SchoolingParams m_params;
+    float m_invCellSize = 1.0f / 60.0f;
+    int m_cols = 1;
+    int m_rows = 1;
+    // entries of cell c are [m_cellStart[c], m_cellStart[c + 1]), sorted by
+    // cell, with the store slot, cell, position and heading of each fish
+    std::vector<int> m_cellStart;
+    std::vector<uint32_t> m_slot;
+    std::vector<int> m_cell;
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_dx;
+    std::vector<float> m_dy;
+    std::vector<uint32_t> m_found; // scratch for rebuild, in store order
+    std::vector<int> m_foundCell;
+};
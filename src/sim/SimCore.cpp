@@ -0,0 +1,192 @@
+#include "SimCore.h"
+#include "Narrowphase.h"
+
+
+// Logging
+namespace {
+    SimLogLevel g_simLogLevel = SimLogLevel::Notice;
+    SimLogSink g_simLogSink;
+
+    const char* SimLogLevelTag(SimLogLevel level) {
+        switch (level) {
+            case SimLogLevel::Verbose: return "verbose";
+            case SimLogLevel::Notice: return "notice";
+            case SimLogLevel::Warning: return "warning";
+            case SimLogLevel::Error: return "error";
+            default: return "";
+        }
+    }
+}
+
+void SetSimLogSink(SimLogSink sink) { g_simLogSink = std::move(sink); }
+void SetSimLogLevel(SimLogLevel level) { g_simLogLevel = level; }
+SimLogLevel GetSimLogLevel() { return g_simLogLevel; }
+
+SimLog::~SimLog() {
+    if (!m_enabled) return;
+    std::string message = m_stream.str();
+    while (!message.empty() && message.back() == '\n') {
+        message.pop_back(); // callers still write std::endl like they did with ofLog
+    }
+    if (g_simLogSink) {
+        g_simLogSink(m_level, message);
+    } else {
+        std::cerr << "[" << SimLogLevelTag(m_level) << "] " << message << std::endl;
+    }
+}
+
+
+// Creature Inherited Base Behavior
+void Creature::setBounds(int w, int h) {
+    m_width = w;
+    m_height = h;
+    if (m_store) {
+        m_store->boundW[m_slot] = w;
+        m_store->boundH[m_slot] = h;
+    }
+}
+
+void Creature::setSpeed(int speed) {
+    m_speed = speed;
+    if (m_store) m_store->step[m_slot] = m_speed * getPassiveSpeedScale();
+}
+
+void Creature::setCollisionRadius(float radius) {
+    if (m_store) {
+        m_store->radius[m_slot] = radius;
+    } else {
+        m_collisionRadius = radius;
+    }
+}
+
+void Creature::setFlipped(bool flipped) {
+    if (m_store) {
+        m_store->flipped[m_slot] = flipped;
+    } else {
+        m_flipped = flipped;
+    }
+}
+
+void Creature::setSprite(SpriteHandle sprite) {
+    if (m_store) {
+        m_store->sprite[m_slot] = std::move(sprite);
+    } else {
+        m_sprite = std::move(sprite);
+    }
+}
+
+void Creature::setValue(int value) {
+    if (m_store) {
+        m_store->value[m_slot] = value;
+    } else {
+        m_value = value;
+    }
+}
+
+void Creature::attachToStore(CreatureStore* store, int slot) {
+    m_store = store;
+    m_slot = slot;
+    store->x[slot] = m_x;
+    store->y[slot] = m_y;
+    store->prevX[slot] = m_x; // nothing to interpolate from yet
+    store->prevY[slot] = m_y;
+    store->dx[slot] = m_dx;
+    store->dy[slot] = m_dy;
+    store->radius[slot] = m_collisionRadius;
+    store->flipped[slot] = m_flipped;
+    store->sprite[slot] = m_sprite;
+    store->step[slot] = m_speed * getPassiveSpeedScale();
+    store->boundW[slot] = m_width;
+    store->boundH[slot] = m_height;
+    store->type[slot] = m_type;
+    store->motion[slot] = getMotion();
+    store->value[slot] = m_value;
+}
+
+// copies the live values back so the creature is still usable (and reports
+// where it was) after leaving the aquarium
+void Creature::detachFromStore() {
+    if (!m_store) return;
+    m_x = m_store->x[m_slot];
+    m_y = m_store->y[m_slot];
+    m_dx = m_store->dx[m_slot];
+    m_dy = m_store->dy[m_slot];
+    m_collisionRadius = m_store->radius[m_slot];
+    m_flipped = m_store->flipped[m_slot];
+    m_sprite = m_store->sprite[m_slot];
+    m_value = m_store->value[m_slot];
+    m_store = nullptr;
+    m_slot = -1;
+}
+
+void Creature::normalize() {
+    float& dx = velX();
+    float& dy = velY();
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length != 0) {
+        dx /= length;
+        dy /= length;
+    }
+}
+
+void Creature::bounce() {
+    // should implement boundary controls here
+    float& x = posX();
+    float& y = posY();
+    float r = radius();
+    //Pared izq.
+   if (x < r) {
+        x = r;
+        velX() = -velX();
+    } else if (x > m_width - r) {  //pared der.
+        x = m_width - r;
+        velX() = -velX();
+    }
+
+    if (y < r) { //borde abajo
+        y = r;
+        velY() = -velY();
+    } else if (y > m_height - r) {
+        y = m_height - r;
+        velY() = -velY();
+    }
+}
+
+
+void GameEvent::print() const {
+
+        switch (type) {
+            case GameEventType::NONE:
+                SIM_LOG_VERBOSE() << "No event." << std::endl;
+                break;
+            case GameEventType::COLLISION:
+                SIM_LOG_VERBOSE() << "Collision event between creatures at ("
+                << creatureA->getX() << ", " << creatureA->getY() << ") and ("
+                << creatureB->getX() << ", " << creatureB->getY() << ")." << std::endl;
+                break;
+            case GameEventType::CREATURE_ADDED:
+                SIM_LOG_VERBOSE() << "Creature added at ("
+                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
+                break;
+            case GameEventType::CREATURE_REMOVED:
+                SIM_LOG_VERBOSE() << "Creature removed at ("
+                << creatureA->getX() << ", " << creatureA->getY() << ")." << std::endl;
+                break;
+            case GameEventType::GAME_OVER:
+                SIM_LOG_VERBOSE() << "Game Over event." << std::endl;
+                break;
+            case GameEventType::NEW_LEVEL:
+                SIM_LOG_VERBOSE() << "New Game level" << std::endl;
+                break;
+            default:
+                SIM_LOG_VERBOSE() << "Unknown event type." << std::endl;
+                break;
+        }
+};
+
+// collision detection between two creatures, the same test the batched
+// narrowphase runs (see Narrowphase.h)
+bool checkCollision(const std::shared_ptr<Creature>& a, const std::shared_ptr<Creature>& b) {
+    if (!a||!b) return false;
+    return CirclesOverlap(a->getX(), a->getY(), a->getCollisionRadius(), b->getX(), b->getY(), b->getCollisionRadius());
+}
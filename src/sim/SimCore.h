@@ -0,0 +1,279 @@
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <functional>
+#include "CreatureStore.h"
+
+// Simulation core. Nothing under src/sim may include ofMain.h: the simulation
+// is also built as a standalone static library (see headless.mk) so it can run
+// on machines without a GL window.
+
+
+class AwaitFrames {
+public:
+	AwaitFrames(int frames) : m_frames(frames), m_counter(0) {}
+	bool tick() {
+		if (m_counter < m_frames) {
+			++m_counter;
+			return false;
+		}
+		m_counter = 0; // Reset counter after reaching the target
+		return true;
+	}
+private:
+	int m_frames;
+	int m_counter;
+};
+
+// Fixed-timestep accumulator. Feed it the real time since the last frame and
+// it says how many simulation steps to run, getAlpha() is how far (0..1) the
+// leftover time is into the next step, for interpolating what gets drawn.
+// A long stall runs at most maxSteps and drops the rest instead of trying to
+// catch up forever.
+class FixedTimestep {
+public:
+	explicit FixedTimestep(double hz = 60.0, int maxSteps = 8) : m_maxSteps(maxSteps) { setRate(hz); }
+	void setRate(double hz) { m_step = 1.0 / std::max(hz, 1.0); }
+	double getRate() const { return 1.0 / m_step; }
+	double getStep() const { return m_step; }
+	int advance(double seconds) {
+		m_accumulator += std::max(seconds, 0.0);
+		int steps = (int)std::floor(m_accumulator / m_step);
+		if (steps > m_maxSteps) {
+			steps = m_maxSteps;
+			m_accumulator = 0.0;
+		} else {
+			m_accumulator -= steps * m_step;
+		}
+		return steps;
+	}
+	float getAlpha() const { return (float)std::min(m_accumulator / m_step, 1.0); }
+private:
+	double m_step = 1.0 / 60.0;
+	double m_accumulator = 0.0;
+	int m_maxSteps;
+};
+
+
+// Logging
+// The simulation logs through its own small stream so it doesn't need ofLog.
+// The app routes it into ofLog with SetSimLogSink, headless runs print to stderr.
+enum class SimLogLevel {
+    Verbose,
+    Notice,
+    Warning,
+    Error,
+    Silent
+};
+
+using SimLogSink = std::function<void(SimLogLevel, const std::string&)>;
+
+void SetSimLogSink(SimLogSink sink);
+void SetSimLogLevel(SimLogLevel level);
+SimLogLevel GetSimLogLevel();
+
+class SimLog {
+public:
+    explicit SimLog(SimLogLevel level) : m_level(level), m_enabled(level >= GetSimLogLevel()) {}
+    SimLog(SimLogLevel level, const std::string& message) : SimLog(level) { *this << message; }
+    SimLog(const SimLog&) = delete;
+    SimLog& operator=(const SimLog&) = delete;
+    ~SimLog();
+
+    template <typename T>
+    SimLog& operator<<(const T& value) {
+        if (m_enabled) { m_stream << value; }
+        return *this;
+    }
+    // std::endl and friends
+    SimLog& operator<<(std::ostream& (*manip)(std::ostream&)) {
+        if (m_enabled) { manip(m_stream); }
+        return *this;
+    }
+
+private:
+    SimLogLevel m_level;
+    bool m_enabled;
+    std::ostringstream m_stream;
+};
+
+// Log macros, use like a stream: SIM_LOG_VERBOSE() << "x: " << x;
+// When the level is off nothing after the macro runs, the arguments aren't
+// even evaluated, and levels below SIM_LOG_MIN_LEVEL (a SimLogLevel number,
+// Notice in NDEBUG builds, Verbose otherwise) compile to nothing at all.
+// They expand to an if/else, so only use them as a whole statement.
+#ifndef SIM_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define SIM_LOG_MIN_LEVEL 1
+#else
+#define SIM_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+#define SIM_LOG_COMPILED(level) ((int)(level) >= SIM_LOG_MIN_LEVEL)
+#define SIM_LOG_IF(condition) if (!(condition)) {} else
+#define SIM_LOG_AT(level) SIM_LOG_IF(SIM_LOG_COMPILED(level) && (level) >= GetSimLogLevel()) SimLog(level)
+
+#define SIM_LOG_VERBOSE() SIM_LOG_AT(SimLogLevel::Verbose)
+#define SIM_LOG_NOTICE() SIM_LOG_AT(SimLogLevel::Notice)
+#define SIM_LOG_WARNING() SIM_LOG_AT(SimLogLevel::Warning)
+#define SIM_LOG_ERROR() SIM_LOG_AT(SimLogLevel::Error)
+
+
+class PlayerCreature;
+class Creature {
+protected:
+    Creature(float x, float y, int speed, float collisionRadius, int value,
+             SpriteHandle sprite)
+    : m_x(x)
+    , m_y(y)
+    , m_dx(0)
+    , m_dy(0)
+    , m_speed(speed)
+    , m_width(0)
+    , m_height(0)
+    , m_collisionRadius(collisionRadius)
+    , m_value(value)
+    , m_sprite(std::move(sprite)) {}
+
+    // Hot state. While the creature is in an aquarium it lives in that
+    // aquarium's CreatureStore and these read and write the arrays there,
+    // otherwise (the player, or before being added) the members below.
+    float& posX() { return m_store ? m_store->x[m_slot] : m_x; }
+    float& posY() { return m_store ? m_store->y[m_slot] : m_y; }
+    float& velX() { return m_store ? m_store->dx[m_slot] : m_dx; }
+    float& velY() { return m_store ? m_store->dy[m_slot] : m_dy; }
+    float posX() const { return m_store ? m_store->x[m_slot] : m_x; }
+    float posY() const { return m_store ? m_store->y[m_slot] : m_y; }
+    float velX() const { return m_store ? m_store->dx[m_slot] : m_dx; }
+    float velY() const { return m_store ? m_store->dy[m_slot] : m_dy; }
+    float radius() const { return m_store ? m_store->radius[m_slot] : m_collisionRadius; }
+    int value() const { return m_store ? m_store->value[m_slot] : m_value; }
+
+    float m_x = 0.0f;
+    float m_y = 0.0f;
+    float m_dx = 0.0f;
+    float m_dy = 0.0f;
+    int m_speed = 0;
+    float m_width = 0.0f;
+    float m_height = 0.0f;
+    float m_collisionRadius = 0.0f;
+    int m_value = 0;
+    int m_powerRequired=1;
+    bool m_flipped = false;
+    SpriteHandle m_sprite;
+     AquariumCreatureType m_type;
+    CreatureStore* m_store = nullptr;
+    int m_slot = -1;
+    CreatureHandle m_handle;
+public:
+    virtual ~Creature() = default;
+    virtual void move() = 0;
+    virtual void move(const std::shared_ptr<PlayerCreature>& /*player*/) {
+    move();
+}
+    // lets Aquarium::update move passive creatures in bulk instead of calling move()
+    virtual CreatureMotion getMotion() const { return CreatureMotion::Custom; }
+    virtual float getPassiveSpeedScale() const { return 1.0f; }
+
+    virtual bool isExpired() const {return false;}
+    virtual float getCollisionRadius() const { return radius(); }
+    virtual void setCollisionRadius(float radius);
+
+    float getX() const { return posX(); }
+    float getY() const { return posY(); }
+    void setPosition(float x, float y) { posX() = x; posY() = y; }
+    int getSpeed() const { return m_speed; }
+    void setSpeed(int speed);
+    bool isFlipped() const { return m_store ? m_store->flipped[m_slot] != 0 : m_flipped; }
+    void setFlipped(bool flipped);
+    SpriteHandle getSprite() const { return m_store ? m_store->sprite[m_slot] : m_sprite; }
+    void setSprite(SpriteHandle sprite);
+    int getValue() const { return value(); }
+    void setValue(int value);
+    float getVelocityX() const { return velX(); }
+    float getVelocityY() const { return velY(); }
+    void setVelocity(float dx, float dy) { velX() = dx; velY() = dy; }
+
+    void setBounds(int w, int h);
+    void normalize();
+    void bounce();
+    int getPowerRequired() const{return m_powerRequired;}
+    void setPowerRequired(int p) {m_powerRequired =p;}
+    AquariumCreatureType getType() const {return m_type;}
+
+    // Moves the hot state into store slot `slot` / back into the members.
+    // Only Aquarium calls these.
+    void attachToStore(CreatureStore* store, int slot);
+    void detachFromStore();
+    void setStoreSlot(int slot) { m_slot = slot; }
+    int getStoreSlot() const { return m_slot; }
+    void setHandle(CreatureHandle handle) { m_handle = handle; }
+    // handle in the aquarium holding the creature, null when it isn't in one
+    CreatureHandle getHandle() const { return m_handle; }
+};
+
+// GameEvents
+enum class GameEventType {
+    NONE,
+    COLLISION,
+    CREATURE_ADDED,
+    CREATURE_REMOVED,
+    GAME_OVER,
+    GAME_EXIT,
+    NEW_LEVEL,
+};
+
+class GameEvent {
+    public:
+    GameEventType type;
+    std::shared_ptr<Creature> creatureA;
+    std::shared_ptr<Creature> creatureB; // For collision events
+    // aquarium handles of A and B when the event was made, use these to act
+    // on the aquarium (a stale one is ignored instead of hitting the wrong fish)
+    CreatureHandle handleA;
+    CreatureHandle handleB;
+    GameEvent() : type(GameEventType::NONE), creatureA(nullptr), creatureB(nullptr) {}
+    GameEvent(GameEventType t, std::shared_ptr<Creature> a , std::shared_ptr<Creature> b){
+        type = t;
+        creatureA = a;
+        creatureB = b;
+        if (a) handleA = a->getHandle();
+        if (b) handleB = b->getHandle();
+    }
+
+    // Additional methods can be added here
+    bool isCollisionEvent() const { return type == GameEventType::COLLISION; }
+    bool isCreatureAddedEvent() const { return type == GameEventType::CREATURE_ADDED; }
+    bool isCreatureRemovedEvent() const { return type == GameEventType::CREATURE_REMOVED; }
+    bool isGameOver() const { return type == GameEventType::GAME_OVER; }
+    bool isGameExit() const { return type == GameEventType::GAME_EXIT; }
+    bool isNoneEvent() const { return type == GameEventType::NONE; }
+
+    // i want a printable representation of the event, with the creature descriptions if available
+    void print() const;
+};
+
+
+
+
+bool checkCollision(const std::shared_ptr<Creature>& a, const std::shared_ptr<Creature>& b);
+
+
+class GameLevel {
+public:
+    GameLevel(int levelNumber) : m_levelNumber(levelNumber) {}
+    virtual ~GameLevel() = default;
+    int getLevelNumber() const { return m_levelNumber; }
+    virtual bool isCompleted() = 0;
+
+protected:
+    int m_levelNumber;
+
+};
@@ -0,0 +1,64 @@
+#include "SimRandom.h"
+#include <array>
+#include <atomic>
+#include "JobSystem.h"
+
+
+namespace {
+    std::atomic<uint64_t> g_simSeed{1};
+    std::atomic<uint32_t> g_seedGeneration{1}; // bumped by SetSimSeed
+
+    struct ThreadGenerators {
+        uint32_t generation = 0; // g_seedGeneration they were seeded under
+        int worker = -1;
+        std::array<Pcg32, (size_t)SimRandomStream::Count> streams;
+    };
+    thread_local ThreadGenerators t_generators;
+
+    // the stream number packs subsystem and substream, so no two
+    // (stream, substream) pairs share a sequence
+    uint64_t StreamId(SimRandomStream stream, uint64_t substream) {
+        return (substream << 8) | (uint64_t)stream;
+    }
+}
+
+void SetSimSeed(uint64_t seed) {
+    g_simSeed = seed;
+    ++g_seedGeneration;
+}
+
+uint64_t GetSimSeed() { return g_simSeed; }
+
+Pcg32& SimRandom(SimRandomStream stream) {
+    ThreadGenerators& generators = t_generators;
+    uint32_t generation = g_seedGeneration.load(std::memory_order_relaxed);
+    int worker = JobSystem::CurrentWorkerIndex();
+    if (generators.generation != generation || generators.worker != worker) {
+        for (size_t i = 0; i < generators.streams.size(); ++i) {
+            generators.streams[i] = MakeSimRandom(SimRandomStream(i), (uint64_t)worker);
+        }
+        generators.generation = generation;
+        generators.worker = worker;
+    }
+    return generators.streams[(size_t)stream];
+}
+
+Pcg32 MakeSimRandom(SimRandomStream stream, uint64_t substream) {
+    return Pcg32(g_simSeed.load(std::memory_order_relaxed), StreamId(stream, substream));
+}
+
+SimRandomState SaveSimRandom() {
+    SimRandomState saved{};
+    for (size_t i = 0; i < (size_t)SimRandomStream::Count; ++i) {
+        const Pcg32& random = SimRandom(SimRandomStream(i));
+        saved.state[i] = random.state();
+        saved.increment[i] = random.increment();
+    }
+    return saved;
+}
+
+void RestoreSimRandom(const SimRandomState& saved) {
+    for (size_t i = 0; i < (size_t)SimRandomStream::Count; ++i) {
+        SimRandom(SimRandomStream(i)).restore(saved.state[i], saved.increment[i]);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// PCG32 (XSH RR, O'Neill): 64 bits of state, 32-bit output, and a stream
+// selector so generators with the same seed but different streams give
+// unrelated sequences. A few instructions per number, no locks, no globals.
+class Pcg32 {
+public:
+    Pcg32() { seed(0x853c49e6748fea9bull, 0xda3e39cb94b95bdbull); }
+    Pcg32(uint64_t seedValue, uint64_t stream) { seed(seedValue, stream); }
+
+    void seed(uint64_t seedValue, uint64_t stream) {
+        m_state = 0;
+        m_increment = (stream << 1) | 1;
+        next();
+        m_state += seedValue;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = m_state;
+        m_state = old * 6364136223846793005ull + m_increment;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // the raw generator, for save states: restore() picks the sequence up
+    // exactly where state() and increment() were read
+    uint64_t state() const { return m_state; }
+    uint64_t increment() const { return m_increment; }
+    void restore(uint64_t state, uint64_t increment) {
+        m_state = state;
+        m_increment = increment | 1;
+    }
+
+    // [0, bound), unbiased (Lemire's multiply and reject)
+    uint32_t below(uint32_t bound) {
+        if (bound == 0) return 0;
+        uint64_t product = (uint64_t)next() * bound;
+        uint32_t low = (uint32_t)product;
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                product = (uint64_t)next() * bound;
+                low = (uint32_t)product;
+            }
+        }
+        return (uint32_t)(product >> 32);
+    }
+    // [low, high], both included
+    int range(int low, int high) { return low + (int)below((uint32_t)(high - low + 1)); }
+    // [0, 1)
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+    uint64_t m_state;
+    uint64_t m_increment;
+};
+
+// Who is drawing numbers. Each subsystem gets its own stream, so adding a
+// draw in one doesn't shift what the others see.
+enum class SimRandomStream {
+    Spawn,    // where and how fast new creatures appear
+    Creature, // per-creature choices (starting direction)
+    Input,    // scripted input in headless runs and benches
+    Count
+};
+
+// Seed for every simulation stream, 1 unless set (from the command line or
+// the app settings). Setting it reseeds all generators, on every thread, the
+// next time they are used.
+void SetSimSeed(uint64_t seed);
+uint64_t GetSimSeed();
+
+// This thread's generator for a stream. Pool workers each get their own
+// (seeded from the worker index), any thread outside the pool shares the
+// numbering of the calling thread, worker 0. Work that has to come out the
+// same whatever thread runs it should use MakeSimRandom with its chunk index.
+Pcg32& SimRandom(SimRandomStream stream);
+
+// a fresh generator for (stream, substream) under the current seed
+Pcg32 MakeSimRandom(SimRandomStream stream, uint64_t substream = 0);
+
+// Where the calling thread's streams are, for save states. Spawning and
+// creature construction draw on the game thread, so these are the streams a
+// snapshot has to carry for play after a load to continue, not restart.
+struct SimRandomState {
+    uint64_t state[(size_t)SimRandomStream::Count];
+    uint64_t increment[(size_t)SimRandomStream::Count];
+};
+SimRandomState SaveSimRandom();
+// under the current seed, until the next SetSimSeed
+void RestoreSimRandom(const SimRandomState& saved);
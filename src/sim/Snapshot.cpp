@@ -0,0 +1,311 @@
+#include "Snapshot.h"
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "AquariumSim.h"
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+    constexpr char SNAPSHOT_MAGIC[4] = {'A', 'Q', 'S', 'S'};
+
+    uint64_t AlignUp(uint64_t offset) { return (offset + 7) / 8 * 8; }
+
+    // the count records at offset, or nullptr if they don't fit in the file
+    template <typename T>
+    const T* RecordsAt(const MappedFile& file, uint64_t offset, uint32_t count) {
+        if (offset % alignof(T) != 0 || offset > file.Size() || (file.Size() - offset) / sizeof(T) < count) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(file.Data() + offset);
+    }
+
+    template <typename T>
+    void WriteRecords(std::ofstream& out, uint64_t& written, uint64_t offset, const T* records, size_t count) {
+        static const char zeros[8] = {};
+        out.write(zeros, offset - written);
+        out.write(reinterpret_cast<const char*>(records), sizeof(T) * count);
+        written = offset + sizeof(T) * count;
+    }
+}
+
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return;
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (size > 0) {
+        unsigned char* data = new unsigned char[size];
+        if (std::fread(data, 1, size, file) == (size_t)size) {
+            m_data = data;
+            m_size = size;
+        } else {
+            delete[] data;
+        }
+    }
+    std::fclose(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const unsigned char*>(data);
+            m_size = info.st_size;
+            m_mapped = true;
+        }
+    }
+    ::close(fd); // the mapping stays valid
+#endif
+}
+
+MappedFile::~MappedFile() {
+    if (!m_data) return;
+#ifdef _WIN32
+    delete[] m_data;
+#else
+    if (m_mapped) ::munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+}
+
+
+SnapshotPlayer PlayerCreature::saveState() const {
+    SnapshotPlayer state{};
+    state.x = posX();
+    state.y = posY();
+    state.dx = velX();
+    state.dy = velY();
+    state.collisionRadius = radius();
+    state.speed = m_speed;
+    state.speedNormal = m_speedNormal;
+    state.score = m_score;
+    state.lives = m_lives;
+    state.power = m_power;
+    state.damageDebounce = m_damage_debounce;
+    state.sizeScale = m_sizeScale;
+    state.sizeTimer = m_sizeTimer;
+    state.speedFruitTime = m_speedFruitTime;
+    state.sizeActive = m_sizeActive;
+    state.speedFruitActive = m_speedFruitActive;
+    state.flipped = isFlipped();
+    return state;
+}
+
+void PlayerCreature::loadState(const SnapshotPlayer& state) {
+    posX() = state.x;
+    posY() = state.y;
+    velX() = state.dx;
+    velY() = state.dy;
+    setCollisionRadius(state.collisionRadius);
+    m_speed = state.speed;
+    m_speedNormal = state.speedNormal;
+    m_score = state.score;
+    m_lives = state.lives;
+    m_power = state.power;
+    m_damage_debounce = state.damageDebounce;
+    m_sizeScale = state.sizeScale;
+    m_sizeTimer = state.sizeTimer;
+    m_speedFruitTime = state.speedFruitTime;
+    m_sizeActive = state.sizeActive != 0;
+    m_speedFruitActive = state.speedFruitActive != 0;
+    setFlipped(state.flipped != 0);
+}
+
+SnapshotLevel AquariumLevel::saveProgress(std::vector<SnapshotPopulation>& populations) const {
+    SnapshotLevel progress{};
+    progress.score = m_level_score;
+    progress.currentWave = m_currentWave;
+    progress.maxWaves = m_maxWaves;
+    progress.waveTimer = m_waveTimer;
+    progress.timeBetweenWaves = m_timeBetweenWaves;
+    progress.completed = m_levelCompleted;
+    progress.firstPopulation = (uint32_t)populations.size();
+    progress.populationCount = (uint32_t)m_levelPopulation.size();
+    for (const auto& node : m_levelPopulation) {
+        populations.push_back(SnapshotPopulation{(int32_t)node->creatureType, node->population, node->currentPopulation});
+    }
+    return progress;
+}
+
+bool AquariumLevel::matchesProgress(const SnapshotLevel& progress, const SnapshotPopulation* populations) const {
+    if (progress.populationCount != m_levelPopulation.size()) return false;
+    for (uint32_t i = 0; i < progress.populationCount; ++i) {
+        if (populations[i].type != (int32_t)m_levelPopulation[i]->creatureType) return false;
+    }
+    return true;
+}
+
+void AquariumLevel::loadProgress(const SnapshotLevel& progress, const SnapshotPopulation* populations) {
+    m_level_score = progress.score;
+    m_currentWave = progress.currentWave;
+    m_maxWaves = progress.maxWaves;
+    m_waveTimer = progress.waveTimer;
+    m_timeBetweenWaves = progress.timeBetweenWaves;
+    m_levelCompleted = progress.completed != 0;
+    for (uint32_t i = 0; i < progress.populationCount; ++i) {
+        m_levelPopulation[i]->population = populations[i].population;
+        m_levelPopulation[i]->currentPopulation = populations[i].currentPopulation;
+    }
+}
+
+
+// header, levels, populations, creatures, each at an 8-byte boundary
+bool AquariumSimulation::SaveSnapshot(const std::string& path) const {
+    const Aquarium& aquarium = *m_aquarium;
+    std::vector<SnapshotLevel> levels;
+    std::vector<SnapshotPopulation> populations;
+    for (int i = 0; i < aquarium.getLevelCount(); ++i) {
+        levels.push_back(aquarium.getLevel(i)->saveProgress(populations));
+    }
+    const std::vector<std::shared_ptr<Creature>>& creatures = aquarium.getCreatures();
+    std::vector<SnapshotCreature> records(creatures.size());
+    for (size_t i = 0; i < creatures.size(); ++i) {
+        const Creature& creature = *creatures[i];
+        SnapshotCreature& record = records[i];
+        record.type = (int32_t)creature.getType();
+        record.x = creature.getX();
+        record.y = creature.getY();
+        record.dx = creature.getVelocityX();
+        record.dy = creature.getVelocityY();
+        record.collisionRadius = creature.getCollisionRadius();
+        record.speed = creature.getSpeed();
+        record.value = creature.getValue();
+        record.powerRequired = creature.getPowerRequired();
+        record.flipped = creature.isFlipped();
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.headerBytes = sizeof(SnapshotHeader);
+    header.seed = GetSimSeed();
+    header.random = SaveSimRandom();
+    header.tick = m_tick;
+    header.width = aquarium.getWidth();
+    header.height = aquarium.getHeight();
+    header.currentLevel = aquarium.getCurrentLevelIndex();
+    header.aquariumTimer = m_aquariumTimer;
+    header.playerPrevX = m_playerPrevX;
+    header.playerPrevY = m_playerPrevY;
+    header.player = m_player->saveState();
+    header.levelOffset = AlignUp(sizeof(SnapshotHeader));
+    header.levelCount = (uint32_t)levels.size();
+    header.populationOffset = AlignUp(header.levelOffset + sizeof(SnapshotLevel) * levels.size());
+    header.populationCount = (uint32_t)populations.size();
+    header.creatureOffset = AlignUp(header.populationOffset + sizeof(SnapshotPopulation) * populations.size());
+    header.creatureCount = (uint32_t)records.size();
+    header.fileBytes = header.creatureOffset + sizeof(SnapshotCreature) * records.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        SIM_LOG_ERROR() << "can't write snapshot " << path;
+        return false;
+    }
+    uint64_t written = 0;
+    WriteRecords(out, written, 0, &header, 1);
+    WriteRecords(out, written, header.levelOffset, levels.data(), levels.size());
+    WriteRecords(out, written, header.populationOffset, populations.data(), populations.size());
+    WriteRecords(out, written, header.creatureOffset, records.data(), records.size());
+    if (!out) {
+        SIM_LOG_ERROR() << "can't write snapshot " << path;
+        return false;
+    }
+    return true;
+}
+
+bool AquariumSimulation::LoadSnapshot(const std::string& path) {
+    if (m_recorder != nullptr || m_replay != nullptr) {
+        SIM_LOG_WARNING() << "can't load " << path << " while recording or replaying input";
+        return false;
+    }
+    MappedFile file(path);
+    if (!file.Data()) {
+        SIM_LOG_ERROR() << "can't open snapshot " << path;
+        return false;
+    }
+    const SnapshotHeader* header = RecordsAt<SnapshotHeader>(file, 0, 1);
+    if (!header || std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        SIM_LOG_ERROR() << path << " is not a snapshot";
+        return false;
+    }
+    if (header->version != SNAPSHOT_VERSION || header->byteOrder != SNAPSHOT_BYTE_ORDER
+        || header->headerBytes != sizeof(SnapshotHeader) || header->fileBytes != file.Size()) {
+        SIM_LOG_ERROR() << path << " is from another version or machine (version " << header->version << ")";
+        return false;
+    }
+    const SnapshotLevel* levels = RecordsAt<SnapshotLevel>(file, header->levelOffset, header->levelCount);
+    const SnapshotPopulation* populations = RecordsAt<SnapshotPopulation>(file, header->populationOffset, header->populationCount);
+    const SnapshotCreature* creatures = RecordsAt<SnapshotCreature>(file, header->creatureOffset, header->creatureCount);
+    if (!levels || !populations || !creatures) {
+        SIM_LOG_ERROR() << path << " is truncated";
+        return false;
+    }
+
+    // check everything before touching the game
+    Aquarium& aquarium = *m_aquarium;
+    if ((int)header->levelCount != aquarium.getLevelCount()
+        || header->currentLevel < 0 || header->currentLevel >= aquarium.getLevelCount()) {
+        SIM_LOG_ERROR() << path << " has " << header->levelCount << " levels, the game has " << aquarium.getLevelCount();
+        return false;
+    }
+    for (uint32_t i = 0; i < header->levelCount; ++i) {
+        const SnapshotLevel& level = levels[i];
+        if ((uint64_t)level.firstPopulation + level.populationCount > header->populationCount) {
+            SIM_LOG_ERROR() << path << " is corrupt";
+            return false;
+        }
+        if (!aquarium.getLevel(i)->matchesProgress(level, populations + level.firstPopulation)) {
+            SIM_LOG_ERROR() << path << ": level " << i + 1 << " doesn't match this game's levels";
+            return false;
+        }
+    }
+    if (header->width != aquarium.getWidth() || header->height != aquarium.getHeight()) {
+        SIM_LOG_WARNING() << path << " was taken in a " << header->width << "x" << header->height << " aquarium";
+    }
+
+    // rebuilding the creatures draws from the Creature stream, so the saved
+    // stream positions go back in afterwards: play after a load continues
+    // the saved game's sequence rather than replaying its opening
+    SetSimSeed(header->seed);
+    for (uint32_t i = 0; i < header->levelCount; ++i) {
+        aquarium.getLevel(i)->loadProgress(levels[i], populations + levels[i].firstPopulation);
+    }
+    aquarium.setCurrentLevelIndex(header->currentLevel);
+    aquarium.clearCreatures();
+    for (uint32_t i = 0; i < header->creatureCount; ++i) {
+        const SnapshotCreature& record = creatures[i];
+        std::shared_ptr<Creature> creature = aquarium.createCreature(AquariumCreatureType(record.type), record.x, record.y, record.speed);
+        if (!creature) continue;
+        aquarium.addCreature(creature);
+        creature->setVelocity(record.dx, record.dy);
+        creature->setCollisionRadius(record.collisionRadius);
+        creature->setValue(record.value);
+        creature->setPowerRequired(record.powerRequired);
+        creature->setFlipped(record.flipped != 0);
+    }
+
+    RestoreSimRandom(header->random);
+
+    m_player->loadState(header->player);
+    m_tick = header->tick;
+    m_aquariumTimer = header->aquariumTimer;
+    m_playerPrevX = header->playerPrevX;
+    m_playerPrevY = header->playerPrevY;
+    m_lastEvent = nullptr;
+    m_events.Clear();
+    return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "SimRandom.h"
+
+// Save-state snapshots of a running game: the aquarium's creatures, the
+// player, every level's progress and the simulation clock. A snapshot is one
+// flat file, a header followed by arrays of the fixed-size records below at
+// 8-byte aligned offsets, written in one pass. Loading maps the file and
+// reads the records in place, nothing is parsed.
+//
+// Records are native byte order and layout. The header carries a byte order
+// tag and the version, a snapshot from another layout is refused rather
+// than misread. Bump SNAPSHOT_VERSION whenever a record changes.
+
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+struct SnapshotPlayer {
+    float x, y, dx, dy;
+    float collisionRadius;
+    int32_t speed;
+    int32_t speedNormal;
+    int32_t score;
+    int32_t lives;
+    int32_t power;
+    float damageDebounce;
+    float sizeScale;
+    float sizeTimer;
+    float speedFruitTime;
+    uint8_t sizeActive;
+    uint8_t speedFruitActive;
+    uint8_t flipped;
+    uint8_t pad;
+};
+
+struct SnapshotLevel {
+    int32_t score;
+    int32_t currentWave;
+    int32_t maxWaves;
+    float waveTimer;
+    float timeBetweenWaves;
+    uint32_t completed;
+    uint32_t firstPopulation; // into the population array
+    uint32_t populationCount;
+};
+
+struct SnapshotPopulation {
+    int32_t type;
+    int32_t population;
+    int32_t currentPopulation;
+};
+
+struct SnapshotCreature {
+    int32_t type;
+    float x, y, dx, dy;
+    float collisionRadius;
+    int32_t speed;
+    int32_t value;
+    int32_t powerRequired;
+    uint32_t flipped;
+};
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder; // SNAPSHOT_BYTE_ORDER as written
+    uint32_t headerBytes;
+    uint64_t fileBytes;
+    uint64_t seed;
+    SimRandomState random; // the game thread's streams, restored after the creatures are rebuilt
+    uint32_t tick;
+    int32_t width;
+    int32_t height;
+    int32_t currentLevel;
+    double aquariumTimer;
+    float playerPrevX;
+    float playerPrevY;
+    SnapshotPlayer player;
+    // arrays: byte offset from the start of the file and element count
+    uint64_t levelOffset;
+    uint32_t levelCount;
+    uint32_t populationCount;
+    uint64_t populationOffset;
+    uint64_t creatureOffset;
+    uint32_t creatureCount;
+    uint32_t pad;
+};
+
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "snapshot records are copied as bytes");
+static_assert(std::is_trivially_copyable<SnapshotLevel>::value, "snapshot records are copied as bytes");
+static_assert(std::is_trivially_copyable<SnapshotPopulation>::value, "snapshot records are copied as bytes");
+static_assert(std::is_trivially_copyable<SnapshotCreature>::value, "snapshot records are copied as bytes");
+
+// Read-only view of a whole file: mmap where there is one, otherwise the
+// file read into memory. Empty (Data() == nullptr) if it couldn't be opened.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+};
@@ -0,0 +1,79 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+
+void SpatialGrid::Configure(float width, float height, float cellSize) {
+    m_cellSize = std::max(cellSize, 1.0f);
+    m_invCellSize = 1.0f / m_cellSize;
+    m_cols = std::max(1, (int)std::ceil(width * m_invCellSize));
+    m_rows = std::max(1, (int)std::ceil(height * m_invCellSize));
+    Clear();
+}
+
+void SpatialGrid::Clear() {
+    m_cellStart.assign(m_cols * m_rows + 1, 0);
+    m_items.clear();
+    m_itemX.clear();
+    m_itemY.clear();
+}
+
+int SpatialGrid::cellX(float x) const {
+    return std::min(std::max((int)std::floor(x * m_invCellSize), 0), m_cols - 1);
+}
+
+int SpatialGrid::cellY(float y) const {
+    return std::min(std::max((int)std::floor(y * m_invCellSize), 0), m_rows - 1);
+}
+
+// counting sort by cell: count, prefix sum, scatter
+void SpatialGrid::Rebuild(size_t count, const float* xs, const float* ys) {
+    m_cellStart.assign(m_cols * m_rows + 1, 0);
+    m_itemCell.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        int cell = cellY(ys[i]) * m_cols + cellX(xs[i]);
+        m_itemCell[i] = cell;
+        ++m_cellStart[cell + 1];
+    }
+    for (size_t c = 1; c < m_cellStart.size(); ++c) {
+        m_cellStart[c] += m_cellStart[c - 1];
+    }
+
+    m_items.resize(count);
+    m_itemX.resize(count);
+    m_itemY.resize(count);
+    // m_cellStart[c] doubles as the write cursor of cell c - 1 while scattering
+    for (size_t i = 0; i < count; ++i) {
+        int slot = m_cellStart[m_itemCell[i]]++;
+        m_items[slot] = i;
+        m_itemX[slot] = xs[i];
+        m_itemY[slot] = ys[i];
+    }
+    // the cursors ended one cell ahead, shift them back into place
+    for (size_t c = m_cellStart.size() - 1; c > 0; --c) {
+        m_cellStart[c] = m_cellStart[c - 1];
+    }
+    m_cellStart[0] = 0;
+}
+
+void SpatialGrid::QueryRadius(float x, float y, float radius, std::vector<int>& out) const {
+    if (m_items.empty() || radius < 0) return;
+    int minX = cellX(x - radius);
+    int maxX = cellX(x + radius);
+    int minY = cellY(y - radius);
+    int maxY = cellY(y + radius);
+    float radiusSq = radius * radius;
+
+    for (int cy = minY; cy <= maxY; ++cy) {
+        for (int cx = minX; cx <= maxX; ++cx) {
+            int cell = cy * m_cols + cx;
+            for (int slot = m_cellStart[cell]; slot < m_cellStart[cell + 1]; ++slot) {
+                float dx = m_itemX[slot] - x;
+                float dy = m_itemY[slot] - y;
+                if (dx * dx + dy * dy <= radiusSq) {
+                    out.push_back(m_items[slot]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Uniform grid over the aquarium for "who is near this point" queries.
+// Items are plain indices (the caller decides what they mean) and the whole
+// grid is rebuilt from a position array in O(n), no per-item allocations.
+// Positions outside the configured area are clamped into the border cells.
+class SpatialGrid {
+public:
+    void Configure(float width, float height, float cellSize);
+    void Rebuild(size_t count, const float* xs, const float* ys);
+    void Clear();
+
+    // appends every item whose position is within radius of (x, y)
+    void QueryRadius(float x, float y, float radius, std::vector<int>& out) const;
+
+    float GetCellSize() const { return m_cellSize; }
+    size_t GetItemCount() const { return m_items.size(); }
+
+private:
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+    float m_cellSize = 128.0f;
+    float m_invCellSize = 1.0f / 128.0f;
+    int m_cols = 1;
+    int m_rows = 1;
+    // items of cell c are m_items[m_cellStart[c] .. m_cellStart[c + 1]),
+    // with their positions copied alongside so queries stay in one array
+    std::vector<int> m_cellStart;
+    std::vector<int> m_items;
+    std::vector<float> m_itemX;
+    std::vector<float> m_itemY;
+    std::vector<int> m_itemCell; // scratch for Rebuild
+};
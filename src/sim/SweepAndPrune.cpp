@@ -0,0 +1,105 @@
+#include "SweepAndPrune.h"
+#include "Narrowphase.h"
+#include <cmath>
+#include <algorithm>
+
+
+// keeps last call's order for the items that still exist and appends new ones
+void SweepAndPrune::syncOrder(size_t count) {
+    if (m_order.size() == count) return;
+    size_t kept = 0;
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        if ((size_t)m_order[i] < count) m_order[kept++] = m_order[i];
+    }
+    m_order.resize(kept);
+    for (size_t i = kept; i < count; ++i) {
+        m_order.push_back(i);
+    }
+}
+
+// Insertion sort, close to O(n) when the order is nearly right from last
+// tick. Removals remap indices and a level change respawns the crowd, so
+// the order can also be far off: once the shifts pass about n log n it
+// gives up and returns false, and the caller sorts from scratch.
+bool SweepAndPrune::repairOrder(size_t count) {
+    size_t budget = count * (size_t)std::max(1.0, std::log2((double)count)) + 64;
+    size_t shifts = 0;
+    for (size_t i = 1; i < count; ++i) {
+        int item = m_order[i];
+        float key = m_minX[item];
+        size_t j = i;
+        while (j > 0 && m_minX[m_order[j - 1]] > key) {
+            m_order[j] = m_order[j - 1];
+            --j;
+        }
+        m_order[j] = item;
+        shifts += i - j;
+        if (shifts > budget) return false;
+    }
+    return true;
+}
+
+void SweepAndPrune::FindOverlaps(size_t count, const float* xs, const float* ys, const float* radii,
+                                 const unsigned char* skip, std::vector<Pair>& pairs) {
+    pairs.clear();
+    syncOrder(count);
+
+    m_minX.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        m_minX[i] = xs[i] - radii[i];
+    }
+
+    if (!repairOrder(count)) {
+        std::sort(m_order.begin(), m_order.end(), [this](int a, int b) { return m_minX[a] < m_minX[b]; });
+    }
+
+    m_sortedMin.resize(count);
+    m_sortedMax.resize(count);
+    m_sortedX.resize(count);
+    m_sortedY.resize(count);
+    m_sortedR.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        int item = m_order[k];
+        m_sortedMin[k] = m_minX[item];
+        m_sortedMax[k] = xs[item] + radii[item];
+        m_sortedX[k] = xs[item];
+        m_sortedY[k] = ys[item];
+        m_sortedR[k] = radii[item];
+    }
+
+    // sweep: everything starting before a's right edge overlaps it on x. That
+    // is one contiguous run of the sorted arrays, tested in a single batch
+    for (size_t k = 0; k < count; ++k) {
+        int a = m_order[k];
+        if (skip && skip[a]) continue;
+        // runs are short, a linear walk beats a binary search here
+        size_t end = k + 1;
+        while (end < count && m_sortedMin[end] <= m_sortedMax[k]) ++end;
+        m_hits.clear();
+        OverlapIndices(m_sortedX[k], m_sortedY[k], m_sortedR[k], m_sortedX.data() + k + 1, m_sortedY.data() + k + 1, m_sortedR.data() + k + 1,
+                       end - (k + 1), m_hits, (int)k + 1);
+        for (int k2 : m_hits) {
+            int b = m_order[k2];
+            if (skip && skip[b]) continue;
+            pairs.push_back(a < b ? Pair(a, b) : Pair(b, a));
+        }
+    }
+}
+
+void SweepAndPrune::Separate(const std::vector<Pair>& pairs, float* xs, float* ys, const float* radii) {
+    for (const Pair& pair : pairs) {
+        int a = pair.first;
+        int b = pair.second;
+        float dx = xs[b] - xs[a];
+        float dy = ys[b] - ys[a];
+        float dist = std::sqrt(dx * dx + dy * dy);
+        float overlap = radii[a] + radii[b] - dist;
+        if (overlap <= 0) continue; // an earlier push already solved it
+        if (dist == 0) { dx = 1; dy = 0; dist = 1; } // same spot, pick a side
+        float push = overlap * 0.5f / dist;
+        xs[a] -= dx * push;
+        ys[a] -= dy * push;
+        xs[b] += dx * push;
+        ys[b] += dy * push;
+    }
+}
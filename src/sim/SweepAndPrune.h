@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// Sort-and-sweep along x for circle vs circle overlaps between many items.
+// The sorted order is kept between calls: fish only move a few pixels per
+// tick, so the insertion sort that repairs it is close to O(n). When the
+// order is far off (a respawned crowd) it falls back to a full sort.
+// Items are indices into the caller's position/radius arrays.
+class SweepAndPrune {
+public:
+    using Pair = std::pair<int, int>;
+
+    // fills pairs with every (a, b), a < b, whose circles overlap.
+    // skip[i] != 0 leaves item i out (may be nullptr)
+    void FindOverlaps(size_t count, const float* xs, const float* ys, const float* radii,
+                      const unsigned char* skip, std::vector<Pair>& pairs);
+
+    // moves every overlapping pair apart along the line between their
+    // centers, each item takes half of the overlap
+    static void Separate(const std::vector<Pair>& pairs, float* xs, float* ys, const float* radii);
+
+    void Reset() { m_order.clear(); }
+
+private:
+    void syncOrder(size_t count);
+    bool repairOrder(size_t count); // false when it gave up, m_order is then unsorted
+
+    std::vector<int> m_order;    // item indices sorted by left edge, reused every call
+    std::vector<float> m_minX;   // left edge per item
+    std::vector<float> m_sortedMin;
+    std::vector<float> m_sortedMax;
+    // positions and radii in sorted order, the narrowphase reads a run of them
+    std::vector<float> m_sortedX;
+    std::vector<float> m_sortedY;
+    std::vector<float> m_sortedR;
+    std::vector<int> m_hits; // scratch, offsets of one item's overlaps
+};